@@ -41,6 +41,9 @@ let equal_upto_tags f f' =
       (fun a -> exists (fun a' -> Prod.equal_upto_tags a a') f2) f1 in
   (subsumed f f') && (subsumed f' f)
 
+let hash_upto_tags f =
+  fold (fun p h -> genhash (Prod.hash_upto_tags p) h) f 0x9e3779b9
+
 let rec uni_subsumption left fhook theta f f' =
   if is_empty f' then fhook theta else
   let p' = choose f' in
@@ -12,6 +12,7 @@ val is_prod : t -> bool
 val terms : t -> Term.Set.t
 
 val equal_upto_tags  : t -> t -> bool
+val hash_upto_tags : t -> int
 val subsumed_wrt_tags : Tags.t -> t -> t -> bool
 
 val subst : Term.substitution -> t -> t
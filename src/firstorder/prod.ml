@@ -66,6 +66,9 @@ let subsumed_wrt_tags tags p1 p2 =
   IndSubfs.subset p1_ips p2_ips
 
 let hash = Hashtbl.hash
+
+(* [Atom.equal_upto_tags] still compares tags, so this is the set hash *)
+let hash_upto_tags = ProdT.hash
 let tag_pairs f = Tagpairs.mk (tags f)
 
 let filter_by_kind a p =
@@ -29,6 +29,7 @@ val left_subsumption :
     Term.substitution -> t -> t -> Term.substitution option
 
 val equal_upto_tags : t -> t -> bool
+val hash_upto_tags : t -> int
 val subsumed_wrt_tags : Tags.t -> t -> t -> bool
 
 val uni_subsumption :
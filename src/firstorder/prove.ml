@@ -30,4 +30,5 @@ let () =
   if String.equal !cl_sequent "" then F.die "-S must be specified." spec_list !F.usage ;
   let seq = Seq.of_string !cl_sequent in
   Rules.setup (Defs.of_channel (open_in !defs_path)) ;
+  Lemmadb.context := Digest.to_hex (Digest.file !defs_path) ;
   F.exit (F.prove_seq !Rules.axioms !Rules.rules seq)
\ No newline at end of file
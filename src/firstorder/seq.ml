@@ -10,8 +10,13 @@ type t = Form.t * Form.t
 let equal (l,r) (l',r') = Form.equal l l' && Form.equal r r'
 let equal_upto_tags (l,r) (l',r') =
   Form.equal_upto_tags l l' && Form.equal_upto_tags r r'
+let hash_upto_tags (l,r) =
+  genhash (Form.hash_upto_tags l) (Form.hash_upto_tags r)
 let dest s = Pair.map Form.dest s
 let tags seq = Form.tags (fst seq)
+let size (l,r) =
+  let form_size f = Form.fold (fun p n -> n + Prod.cardinal p) f 0 in
+  form_size l + form_size r
 let to_string (l,r) = (Form.to_string l) ^ " |- " ^ (Form.to_string r)
 let pp fmt (l,r) = Format.fprintf fmt "@[%a |-@ %a@]" Form.pp l Form.pp r
 let parse st =
@@ -5,8 +5,10 @@ type t = Form.t * Form.t
 
 val equal : t -> t -> bool
 val equal_upto_tags : t -> t -> bool
+val hash_upto_tags : t -> int
 val to_string : t -> string
 val pp : Format.formatter -> t -> unit
+val size : t -> int
 val of_string : string -> t
 
 val tags : t -> Tags.t
@@ -22,6 +22,9 @@ module Node =
   Lines beginning with the same node id are merged.
 
   A value of Soundcheck.t is returned.
+
+  Proofs are actually read with the hand-written Proofparser; these
+  combinators are kept as a reference implementation for the -bench mode.
 *)
 
 let id_exp =
@@ -106,28 +109,456 @@ let mk_prf lines =
 let parse_proof s =
   (many parse_line |>> mk_prf) s
 
+type verdict = NO | YES | MALFORMED
+
+let check_input input =
+  match Proofparser.of_string input with
+  | exception Proofparser.Error _ -> MALFORMED
+  | prf, init -> (
+      try if check_proof ~init prf then YES else NO
+      with Assert_failure _ | Invalid_argument _ | Not_found -> MALFORMED )
+
+(*
+  Server mode.
+
+  Proofs are received as frames of the form
+
+    <request-id> <payload-length> <payload>
+
+  where the first two fields are 32-bit big-endian integers and <payload> is
+  a proof in the text format above (the terminating ';' is optional).  Each
+  request is answered by a frame
+
+    <request-id> <verdict>
+
+  where <verdict> is a single byte: 1 for YES, 0 for NO and 2 if the proof
+  could not be parsed or is malformed, or its check failed.  A frame whose
+  length is negative or exceeds [max_payload] is answered with 2 and ends
+  the reading of requests, as the frames after it cannot be told apart.
+  Frames are read from stdin and
+  answered on stdout, unless a Unix socket is given, in which case
+  connections are served one after the other.  Proofs are checked on a pool
+  of worker processes, so responses may arrive out of request order.
+*)
+
+let byte_of_verdict = function NO -> 0 | YES -> 1 | MALFORMED -> 2
+
+let rec really_read fd buf ofs len =
+  if Int.( > ) len 0 then (
+    let n = Unix.read fd buf ofs len in
+    if Int.equal n 0 then raise End_of_file ;
+    really_read fd buf (ofs + n) (len - n) )
+
+exception Bad_frame of int32
+
+let max_payload = 1 lsl 26
+
+let read_request fd =
+  let hdr = Bytes.create 8 in
+  really_read fd hdr 0 8 ;
+  let id = Bytes.get_int32_be hdr 0 in
+  let len = Int32.to_int (Bytes.get_int32_be hdr 4) in
+  if Int.( < ) len 0 || Int.( > ) len max_payload then raise (Bad_frame id) ;
+  let payload = Bytes.create len in
+  really_read fd payload 0 len ;
+  (id, Bytes.unsafe_to_string payload)
+
+let response id verdict =
+  let buf = Bytes.create 5 in
+  Bytes.set_int32_be buf 0 id ;
+  Bytes.set_uint8 buf 4 (byte_of_verdict verdict) ;
+  buf
+
+(* a worker that fails exits without answering, and the server replaces it *)
+let spawn_worker others =
+  Worker.spawn ~siblings:others (fun requests answers ->
+      (* stdout may be the client channel of the server, so keep any
+         diagnostic output of the checker away from it *)
+      Unix.dup2 Unix.stderr Unix.stdout ;
+      while true do
+        let id, payload = (Marshal.from_channel requests : int32 * string) in
+        Marshal.to_channel answers (id, check_input payload) [] ;
+        flush answers
+      done )
+
+(* [workers] is an array, so that a worker that dies can be replaced *)
+let serve workers (in_fd, out_fd) =
+  let nworkers = Array.length workers in
+  let pending = Queue.create () in
+  let idle = Queue.create () in
+  let () = Array.iter (fun w -> Queue.add w idle) workers in
+  (* the request each busy worker is checking, by pid *)
+  let checking = Hashtbl.create nworkers in
+  let reading = ref true in
+  let client_open = ref true in
+  let reply buf =
+    if !client_open then
+      try ignore (Unix.write out_fd buf 0 (Bytes.length buf))
+      with Unix.Unix_error (Unix.EPIPE, _, _) -> client_open := false
+  in
+  (* a worker that died, e.g. of a stack overflow in the checker, is
+     replaced, and the request it was checking answered as malformed *)
+  let respawn w =
+    let id = Hashtbl.find checking w.Worker.pid in
+    Hashtbl.remove checking w.Worker.pid ;
+    Worker.shutdown [w] ;
+    let others = List.filter (fun w' -> w' != w) (Array.to_list workers) in
+    let w' = spawn_worker others in
+    Array.iteri (fun i w'' -> if w'' == w then workers.(i) <- w') workers ;
+    Queue.add w' idle ;
+    reply (response id MALFORMED)
+  in
+  while
+    (!reading && !client_open)
+    || (not (Queue.is_empty pending))
+    || Int.( < ) (Queue.length idle) nworkers
+  do
+    while not (Queue.is_empty pending || Queue.is_empty idle) do
+      let w = Queue.pop idle in
+      let ((id, _) as req) = Queue.pop pending in
+      Hashtbl.replace checking w.Worker.pid id ;
+      try Worker.send w (req : int32 * string) with Sys_error _ -> respawn w
+    done ;
+    let busy =
+      List.filter
+        (fun w -> not (Queue.fold (fun b w' -> b || w == w') false idle))
+        (Array.to_list workers)
+    in
+    (* stop reading requests while there is a backlog, so that a fast client
+       cannot make us buffer without bound *)
+    let listen =
+      if
+        !reading && !client_open
+        && Int.( < ) (Queue.length pending) nworkers
+      then [in_fd]
+      else []
+    in
+    let input, answered = Worker.select listen busy in
+    List.iter
+      (fun w ->
+        match (Worker.receive w : (int32 * verdict) option) with
+        | Some (id, verdict) ->
+            Hashtbl.remove checking w.Worker.pid ;
+            reply (response id verdict) ;
+            Queue.add w idle
+        | None -> respawn w )
+      answered ;
+    if not (Blist.is_empty input) then
+      match read_request in_fd with
+      | req -> Queue.add req pending
+      | exception Bad_frame id ->
+          reply (response id MALFORMED) ;
+          reading := false
+      | exception (End_of_file | Unix.Unix_error (Unix.ECONNRESET, _, _)) ->
+          reading := false
+  done
+
+let run_server nworkers socket_path =
+  let () = Sys.set_signal Sys.sigpipe Sys.Signal_ignore in
+  let workers =
+    Array.of_list
+      (Blist.fold_left
+         (fun ws _ -> spawn_worker ws :: ws)
+         [] (Blist.repeat () (Int.max 1 nworkers)))
+  in
+  let () =
+    if String.equal socket_path "" then serve workers (Unix.stdin, Unix.stdout)
+    else
+      let sock = Unix.socket Unix.PF_UNIX Unix.SOCK_STREAM 0 in
+      let () =
+        match Unix.stat socket_path with
+        | {Unix.st_kind= Unix.S_SOCK; _} -> Unix.unlink socket_path
+        | _ -> ()
+        | exception Unix.Unix_error (Unix.ENOENT, _, _) -> ()
+      in
+      Unix.bind sock (Unix.ADDR_UNIX socket_path) ;
+      Unix.listen sock 16 ;
+      while true do
+        let conn, _ = Unix.accept sock in
+        serve workers (conn, conn) ;
+        Unix.close conn
+      done
+  in
+  Worker.shutdown (Array.to_list workers)
+
+let server = ref false
+
+let socket_path = ref ""
+
+let nworkers = ref 1
+
+let bench_path = ref ""
+
+let batch = ref false
+
+let inputs = ref []
+
+let usage =
+  "usage: " ^ Sys.argv.(0)
+  ^ " [-server [-j <int>] [-u <file>]] [-bench <file>]"
+  ^ " [-batch <file-or-dir> ...]"
+
+let speclist =
+  [ ("-d", Arg.Set do_debug, ": print debug messages")
+  ; ( "-server"
+    , Arg.Set server
+    , ": read framed proofs and answer with tagged verdicts" )
+  ; ( "-j"
+    , Arg.Set_int nworkers
+    , ": number of worker processes in server mode, default is "
+      ^ string_of_int !nworkers )
+  ; ( "-u"
+    , Arg.Set_string socket_path
+    , ": in server mode, listen on the Unix socket <file> instead of stdin" )
+  ; ( "-bench"
+    , Arg.Set_string bench_path
+    , ": measure parsing throughput on the proofs in <file>, check that both \
+       parsers agree on them and exit" )
+  ; ( "-batch"
+    , Arg.Set batch
+    , ": check every proof in the given files and directories, printing JSON \
+       Lines" ) ]
+
+let run_bench path =
+  let ic = open_in_bin path in
+  let input = really_input_string ic (in_channel_length ic) in
+  let () = close_in ic in
+  let mbytes = float_of_int (String.length input) /. 1048576.0 in
+  let measure name parse =
+    let start = Unix.gettimeofday () in
+    let proofs = parse input in
+    let elapsed = Unix.gettimeofday () -. start in
+    Printf.printf "%s: %d proofs in %.3f s, %.1f MB/s\n" name
+      (Blist.length proofs) elapsed
+      (if Stdlib.( = ) elapsed 0. then 0. else mbytes /. elapsed) ;
+    proofs
+  in
+  Printf.printf "Input: %s, %.1f MB\n" path mbytes ;
+  let fast =
+    measure "Proofparser" (fun input ->
+        Blist.rev (Proofparser.fold (fun ps p -> p :: ps) [] input) )
+  in
+  let reference =
+    measure "MParser" (fun input ->
+        handle_reply
+          (parse_string
+             (spaces >> many (parse_proof << Tokens.semi) << eof)
+             input ()) )
+  in
+  (* node and tag numbers differ between the two, so proofs are compared by *)
+  (* their sizes and verdicts *)
+  let agree (prf, init) (prf', init') =
+    let r = check_proof_report ~init prf in
+    let r' = check_proof_report ~init:init' prf' in
+    Bool.equal r.sound r'.sound
+    && Int.equal (fst r.size) (fst r'.size)
+    && Int.equal (snd r.size) (snd r'.size)
+  in
+  let mismatch =
+    if not (Int.equal (Blist.length fast) (Blist.length reference)) then
+      Some "numbers of proofs"
+    else
+      Option.map
+        (fun i -> "proof " ^ string_of_int i)
+        (Blist.find_map Fun.id
+           (Blist.mapi
+              (fun i (p, p') -> if agree p p' then None else Some i)
+              (Blist.combine fast reference)))
+  in
+  match mismatch with
+  | None -> print_endline "Parsers agree."
+  | Some what ->
+      prerr_endline ("Parsers disagree on " ^ what) ;
+      exit 1
+
+(*
+  Batch mode.
+
+  Every proof in the input files (directories are traversed recursively) is
+  parsed and checked, and a JSON record is written on a line of its own:
+
+    {"file": <string>, "proof": <int>, "verdict": "YES" | "NO" | "MALFORMED",
+     "nodes": <int>, "edges": <int>, "min_nodes": <int>, "min_edges": <int>,
+     "cache": "hit" | "miss" | "none", "parse_ms": <float>,
+     "validate_ms": <float>, "minimise_ms": <float>, "check_ms": <float>,
+     "total_ms": <float>}
+
+  where "proof" is the index of the proof within its file.  Malformed proofs
+  only carry "file", "proof", "verdict", "error" and "parse_ms".  A histogram
+  of total latencies is printed on stderr at the end.
+*)
+
+let rec collect_files path acc =
+  if Sys.is_directory path then
+    Blist.fold_left
+      (fun acc f -> collect_files (Filename.concat path f) acc)
+      acc
+      (Blist.sort String.compare (Array.to_list (Sys.readdir path)))
+  else path :: acc
+
+let ms t = 1000.0 *. t
+
+let print_latency_summary latencies =
+  let latencies = Array.of_list latencies in
+  let n = Array.length latencies in
+  let () = Array.sort Stdlib.compare latencies in
+  let percentile p =
+    latencies.(Int.min (n - 1) (int_of_float (p *. float_of_int n)))
+  in
+  (* decade buckets, from under 10us up to 10s and over *)
+  let bounds = [0.01; 0.1; 1.; 10.; 100.; 1000.; 10000.] in
+  let labels =
+    [ "< 10us"; "< 100us"; "< 1ms"; "< 10ms"; "< 100ms"; "< 1s"; "< 10s"
+    ; ">= 10s" ]
+  in
+  let counts = Array.make (Blist.length labels) 0 in
+  let bucket t =
+    let rec aux i = function
+      | [] -> i
+      | b :: bs -> if Stdlib.( < ) t b then i else aux (i + 1) bs
+    in
+    aux 0 bounds
+  in
+  Array.iter
+    (fun t ->
+      let i = bucket t in
+      counts.(i) <- counts.(i) + 1 )
+    latencies ;
+  let widest = Array.fold_left Int.max 1 counts in
+  Printf.eprintf "Checked %d proofs.\n" n ;
+  if Int.( > ) n 0 then (
+    Printf.eprintf
+      "Latency (ms): mean %.3f, p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n"
+      (Array.fold_left ( +. ) 0. latencies /. float_of_int n)
+      (percentile 0.5) (percentile 0.9) (percentile 0.99) latencies.(n - 1) ;
+    Blist.iteri
+      (fun i label ->
+        Printf.eprintf "%8s %8d %s\n" label counts.(i)
+          (String.make (50 * counts.(i) / widest) '#') )
+      labels )
+
+let run_batch paths =
+  let latencies = ref [] in
+  let rec skip_blank s pos =
+    if Int.( < ) pos (String.length s) then
+      match s.[pos] with
+      | ' ' | '\t' | '\n' | '\r' -> skip_blank s (pos + 1)
+      | _ -> pos
+    else pos
+  in
+  let malformed file idx parse_time msg =
+    Printf.printf
+      "{\"file\": %s, \"proof\": %d, \"verdict\": \"MALFORMED\", \
+       \"error\": %s, \"parse_ms\": %.3f}\n"
+      (Strng.to_json file) idx (Strng.to_json msg) (ms parse_time)
+  in
+  let checked file idx parse_time r =
+    let total =
+      parse_time +. r.validate_time +. r.minimise_time +. r.check_time
+    in
+    latencies := ms total :: !latencies ;
+    Printf.printf
+      "{\"file\": %s, \"proof\": %d, \"verdict\": \"%s\", \"nodes\": %d, \
+       \"edges\": %d, \"min_nodes\": %d, \"min_edges\": %d, \"cache\": \
+       \"%s\", \"parse_ms\": %.3f, \"validate_ms\": %.3f, \"minimise_ms\": \
+       %.3f, \"check_ms\": %.3f, \"total_ms\": %.3f}\n"
+      (Strng.to_json file) idx
+      (if r.sound then "YES" else "NO")
+      (fst r.size) (snd r.size) (fst r.min_size) (snd r.min_size)
+      (match r.cache with Hit -> "hit" | Miss -> "miss" | Bypassed -> "none")
+      (ms parse_time) (ms r.validate_time) (ms r.minimise_time)
+      (ms r.check_time) (ms total)
+  in
+  let process_file file =
+    let ic = open_in_bin file in
+    let s = really_input_string ic (in_channel_length ic) in
+    let () = close_in ic in
+    let stop = String.length s in
+    let rec aux idx pos =
+      let pos = skip_blank s pos in
+      if Int.( < ) pos stop then
+        let start = Unix.gettimeofday () in
+        match Proofparser.parse s pos stop with
+        | exception Proofparser.Error (epos, what) ->
+            malformed file idx
+              (Unix.gettimeofday () -. start)
+              (Printf.sprintf "offset %d: expected %s" epos what) ;
+            (* resume after the end of the offending proof *)
+            aux (idx + 1)
+              (Option.dest stop succ (String.index_from_opt s epos ';'))
+        | (prf, init), pos' ->
+            let parse_time = Unix.gettimeofday () -. start in
+            ( match Soundcheck.check_proof_report ~init prf with
+            | r -> checked file idx parse_time r
+            | exception (Assert_failure _ | Invalid_argument _ | Not_found) ->
+                malformed file idx parse_time "invalid proof" ) ;
+            aux (idx + 1) pos'
+    in
+    aux 0 0
+  in
+  Blist.iter process_file
+    (Blist.rev (Blist.fold_left (fun acc p -> collect_files p acc) [] paths)) ;
+  print_latency_summary !latencies
+
+(* Proofs are answered as soon as their terminating ';' has been read, so
+   input is consumed in whatever chunks are available rather than up to EOF. *)
+let run_interactive () =
+  let buf = ref (Bytes.create 65536) in
+  let len = ref 0 in
+  let answer from stop =
+    match Proofparser.parse (Bytes.unsafe_to_string !buf) from stop with
+    | exception Proofparser.Error (pos, what) ->
+        prerr_endline
+          (Printf.sprintf "Parse error at offset %d: expected %s" pos what) ;
+        exit 1
+    | (prf, init), _ ->
+        if check_proof ~init prf then print_endline "YES"
+        else print_endline "NO"
+  in
+  let rec answer_complete from i =
+    if Int.( >= ) i !len then from
+    else if Char.equal (Bytes.get !buf i) ';' then (
+      answer from (i + 1) ;
+      answer_complete (i + 1) (i + 1) )
+    else answer_complete from (i + 1)
+  in
+  let is_blank from =
+    let rec aux i =
+      Int.( >= ) i !len
+      || (match Bytes.get !buf i with
+         | ' ' | '\t' | '\n' | '\r' -> true
+         | _ -> false)
+         && aux (i + 1)
+    in
+    aux from
+  in
+  while true do
+    if Int.equal !len (Bytes.length !buf) then (
+      let buf' = Bytes.create (2 * !len) in
+      Bytes.blit !buf 0 buf' 0 !len ;
+      buf := buf' ) ;
+    let n = input stdin !buf !len (Bytes.length !buf - !len) in
+    if Int.equal n 0 then (
+      if not (is_blank 0) then answer 0 !len ;
+      exit 0 ) ;
+    let start = !len in
+    len := !len + n ;
+    let from = answer_complete 0 start in
+    Bytes.blit !buf from !buf 0 (!len - from) ;
+    len := !len - from
+  done
+
 let () =
   let () = gc_setup () in
   let () = Format.set_margin (Sys.command "exit $(tput cols)") in
-  let buf = Buffer.create 2014 in
-  while true do
-    let ready = 
-      try
-        let c = input_char stdin in
-        let () = Buffer.add_char buf c in
-        Char.equal c ';'
-      with End_of_file -> true in
-    if ready then
-      let input = Buffer.contents buf in
-      let () = Buffer.clear buf in
-      match (parse_string (spaces >> eof) input ()) with
-      | Success _ ->
-        exit 0
-      | Failed _ ->
-        let (prf, init) =
-          handle_reply
-            (parse_string (spaces >> parse_proof << Tokens.semi) input ()) in
-        if (check_proof ~init prf)
-          then print_endline "YES"
-          else print_endline "NO"
-  done
+  let () =
+    Arg.parse speclist (fun path -> inputs := path :: !inputs) usage
+  in
+  if (not !batch) && not (Blist.is_empty !inputs) then (
+    prerr_endline "Stray argument found." ;
+    prerr_endline (Arg.usage_string speclist usage) ;
+    exit 1 ) ;
+  if not (String.equal !bench_path "") then run_bench !bench_path
+  else if !batch then run_batch (Blist.rev !inputs)
+  else if !server then run_server !nworkers !socket_path
+  else run_interactive ()
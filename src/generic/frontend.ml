@@ -17,6 +17,48 @@ module Make (Prover : Prover.S) = struct
 
   let maxbound = ref 11
 
+  let heuristic = ref ""
+
+  let breadth_first = ref false
+
+  let strategy h bfs ax r =
+    heuristic := h ;
+    breadth_first := bfs ;
+    (ax, r)
+
+  (* A portfolio configuration adjusts the settings above and/or the axioms *)
+  (* and rules before a search.  Front-ends may extend the list. *)
+  let portfolio =
+    ref
+      [ ("idfs", strategy "" false)
+      ; ("bf-backlinks", strategy "backlinks" false)
+      ; ("bf-goals", strategy "goals" false)
+      ; ("bfs", strategy "" true)
+      ; ( "idfs-from-4"
+        , fun ax r ->
+            minbound := Int.max !minbound 4 ;
+            strategy "" false ax r )
+      ; ("bf-preds", strategy "preds" false)
+      ; ("bf-size", strategy "size" false) ]
+
+  (* Whatever a configuration sets is saved by one of the functions below, *)
+  (* which returns another to restore it.  Front-ends adding configurations *)
+  (* that set more add functions for those settings. *)
+  let saving setting () =
+    let value = !setting in
+    fun () -> setting := value
+
+  let portfolio_settings =
+    ref [saving heuristic; saving breadth_first; saving minbound]
+
+  let portfolio_size = ref 0
+
+  let portfolio_log = ref ""
+
+  (* sequents are looked up in [Lemmadb] under the key below, which *)
+  (* front-ends may normalise with [Lemmadb.normalise] *)
+  let lemma_key = ref Seq.to_string
+
   let speclist =
     ref (fun () ->
         [ ( "-m"
@@ -33,9 +75,59 @@ module Make (Prover : Prover.S) = struct
                 minbound := n ;
                 maxbound := n )
           , ": set both depths to <int>." )
+        ; ( "-tt"
+          , Arg.Set Prover.transpositions
+          , ": keep a transposition table across IDFS iterations, may miss \
+             proofs" )
+        ; ( "-ng"
+          , Arg.Set Prover.nogoods
+          , ": fail at once on sequents that already failed to close, up to \
+             tags, with at least the remaining depth, may miss proofs" )
+        ; ( "-j"
+          , Arg.Set_int Prover.jobs
+          , ": search the alternatives at the root with <int> processes, \
+             which keep no -tt/-ng table, default is "
+            ^ string_of_int !Prover.jobs )
+        ; ( "-bf"
+          , Arg.Symbol
+              (Blist.map fst Prover.heuristics, fun h -> heuristic := h)
+          , " use best-first search ordered by the given heuristic instead of \
+             IDFS, up to the maximum depth" )
+        ; ("-bfs", Arg.Set breadth_first, ": use breadth-first search")
+        ; ( "-bfscap"
+          , Arg.Set_int Prover.bfs_frontier_cap
+          , ": fall back to IDFS once more than <int> partial proofs are \
+             queued by breadth-first search, default is "
+            ^ string_of_int !Prover.bfs_frontier_cap )
+        ; ( "-portfolio"
+          , Arg.Set_int portfolio_size
+          , ": race the first <int> portfolio configurations in separate \
+             processes, 0 disables it, default is "
+            ^ string_of_int !portfolio_size )
+        ; ( "-portfolio-log"
+          , Arg.Set_string portfolio_log
+          , ": append the winning portfolio configuration to <file>" )
+        ; ( "-cp"
+          , Arg.Set_string Prover.checkpoint
+          , ": save the progress of IDFS to <file> on timeout or interruption, \
+             and resume from <file> if it records the same sequent" )
+        ; ( "-db"
+          , Arg.Set_string Lemmadb.path
+          , ": look up the outcomes of earlier searches in, and record new \
+             ones to, the lemma database <file>" )
         ; ("-p", Arg.Set show_proof, ": show proof")
         ; ("-d", Arg.Set do_debug, ": print debug messages")
         ; ("-s", Arg.Set Stats.do_statistics, ": print statistics")
+        ; ( "-rp"
+          , Arg.Set Stats.Rules.enabled
+          , ": profile the proof rules, printing the profile with -s" )
+        ; ( "-rpjson"
+          , Arg.String
+              (fun path ->
+                Stats.Rules.enabled := true ;
+                Stats.Rules.json_path := path )
+          , ": profile the proof rules and write the profile to <file> as \
+             JSON" )
         ; ("-l", Arg.Set_string latex_path, ": write proofs to <file>")
         ; ( "-t"
           , Arg.Set_int timeout
@@ -58,12 +150,21 @@ module Make (Prover : Prover.S) = struct
   let gather_stats call =
     Stats.reset () ;
     Stats.Gen.call () ;
+    let checkpointing = not (String.equal !Prover.checkpoint "") in
+    (* treat interruptions as timeouts, so that progress is saved *)
+    if checkpointing then (
+      Sys.set_signal Sys.sigint sigalrm_handler ;
+      Sys.set_signal Sys.sigterm sigalrm_handler ) ;
     let res =
-      if not (Int.equal !timeout 0) then w_timeout call !timeout
+      if checkpointing || not (Int.equal !timeout 0) then
+        w_timeout call !timeout
       else Some (call ())
     in
     Stats.Gen.end_call () ;
     if !Stats.do_statistics then Stats.gen_print () ;
+    (* the profile is written whether or not statistics are printed *)
+    if not (String.equal !Stats.Rules.json_path "") then
+      Stats.Rules.write_json !Stats.Rules.json_path ;
     res
 
   let process_result output seq res =
@@ -83,9 +184,112 @@ module Make (Prover : Prover.S) = struct
         if !Stats.do_statistics then Prover.print_proof_stats proof ;
         SUCCESS proof
 
-  let idfs ax r seq =
+  let search ax r seq =
     let maxbound = if Int.( < ) !maxbound 1 then max_int else !maxbound in
-    Prover.idfs !minbound maxbound ax r seq
+    match
+      Blist.find_opt
+        (fun (name, _) -> String.equal name !heuristic)
+        Prover.heuristics
+    with
+    | Some (_, h) -> Prover.best_first maxbound h ax r seq
+    | None when !breadth_first -> Prover.bfs !minbound maxbound ax r seq
+    | None -> Prover.idfs !minbound maxbound ax r seq
+
+  (* each configuration runs in its own process, which answers with the *)
+  (* script of the proof it found, if any, along with the search depth *)
+  (* a configuration that fails answers nothing *)
+  let spawn_config ax r seq (name, setup) =
+    let race_config _ oc =
+      let ax, r = setup ax r in
+      let res =
+        Option.map
+          (fun prf -> (Prover.script ax r prf, !Prover.last_search_depth))
+          (search ax r seq)
+      in
+      Marshal.to_channel oc (res : (int list * int) option) []
+    in
+    (name, setup, Worker.spawn race_config)
+
+  let log_winner seq winner elapsed =
+    if !Stats.do_statistics then
+      Printf.printf "PORTFOLIO: %s after %.0f ms\n"
+        (Option.dest "no configuration succeeded" (fun n -> n ^ " won") winner)
+        (1000.0 *. elapsed) ;
+    if not (String.equal !portfolio_log "") then (
+      let oc =
+        open_out_gen [Open_creat; Open_append; Open_text] 0o644 !portfolio_log
+      in
+      Printf.fprintf oc "%s\t%.0f\t%s\n"
+        (Option.dest "-" Fun.id winner)
+        (1000.0 *. elapsed) (Seq.to_string seq) ;
+      close_out oc )
+
+  let race ax r seq =
+    let configs =
+      Blist.take
+        (Int.min !portfolio_size (Blist.length !portfolio))
+        !portfolio
+    in
+    let start = Unix.gettimeofday () in
+    let racers = Blist.map (spawn_config ax r seq) configs in
+    let shutdown () = Worker.shutdown (Blist.map (fun (_, _, w) -> w) racers) in
+    let rec loop running =
+      if Blist.is_empty running then None
+      else
+        let ready = Worker.ready (Blist.map (fun (_, _, w) -> w) running) in
+        let finished, running =
+          Blist.partition (fun (_, _, w) -> Blist.memq w ready) running
+        in
+        let answer (_, _, w) =
+          (* a racer that died without answering has failed *)
+          Option.flatten (Worker.receive w : (int list * int) option option)
+        in
+        match
+          Blist.find_map
+            (fun ((name, setup, _) as racer) ->
+              Option.map (fun res -> (name, setup, res)) (answer racer) )
+            finished
+        with
+        | None -> loop running
+        | res -> res
+    in
+    let winner =
+      try
+        let winner = loop racers in
+        shutdown () ; winner
+      with e -> shutdown () ; raise e
+    in
+    log_winner seq
+      (Option.map (fun (name, _, _) -> name) winner)
+      (Unix.gettimeofday () -. start) ;
+    (* the proof is rebuilt under the settings of the winner, which must not *)
+    (* carry over to later races *)
+    let rebuild (_, setup, (script, depth)) =
+      let restore = Blist.map (fun save -> save ()) !portfolio_settings in
+      let restore () = Blist.iter (fun f -> f ()) restore in
+      try
+        let ax, r = setup ax r in
+        Prover.last_search_depth := depth ;
+        let prf = Prover.rebuild ax r seq script in
+        restore () ; prf
+      with e -> restore () ; raise e
+    in
+    Option.map rebuild winner
+
+  let run ax r seq =
+    if Int.( > ) !portfolio_size 0 then race ax r seq else search ax r seq
+
+  let idfs ax r seq =
+    if not (Lemmadb.enabled ()) then run ax r seq
+    else
+      let key = !lemma_key seq in
+      let maxbound = if Int.( < ) !maxbound 1 then max_int else !maxbound in
+      match Prover.lookup ax r maxbound key seq with
+      | Some res -> res
+      | None ->
+          let res = run ax r seq in
+          Prover.remember ax r maxbound key res ;
+          res
 
   let prove_seq ax r seq =
     Format.set_margin (Sys.command "exit $(tput cols)") ;
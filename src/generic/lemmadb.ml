@@ -0,0 +1,119 @@
+open Lib
+
+type entry = {script: (int list * int) option; failed: int}
+
+let no_entry = {script= None; failed= -1}
+
+let path = ref ""
+
+let context = ref ""
+
+let enabled () = not (String.equal !path "")
+
+let is_ident_char = function
+  | 'a' .. 'z' | 'A' .. 'Z' | '0' .. '9' | '_' | '\'' -> true
+  | _ -> false
+
+let normalise names s =
+  let names = Strng.Set.of_list names in
+  let renaming = Hashtbl.create 17 in
+  let rename id =
+    match Hashtbl.find_opt renaming id with
+    | Some id' -> id'
+    | None ->
+        let quoted = Char.equal id.[String.length id - 1] '\'' in
+        let id' =
+          "_"
+          ^ string_of_int (Hashtbl.length renaming)
+          ^ if quoted then "'" else ""
+        in
+        Hashtbl.add renaming id id' ; id'
+  in
+  let n = String.length s in
+  let b = Buffer.create n in
+  let rec ident_end j =
+    if Int.( < ) j n && is_ident_char s.[j] then ident_end (j + 1) else j
+  in
+  let rec scan i =
+    if Int.( < ) i n then
+      if is_ident_char s.[i] then (
+        let j = ident_end i in
+        let id = String.sub s i (j - i) in
+        let applied =
+          Int.( < ) j n && (Char.equal s.[j] '(' || Char.equal s.[j] '[')
+        in
+        Buffer.add_string b
+          (if applied || not (Strng.Set.mem id names) then id else rename id) ;
+        scan j )
+      else (
+        Buffer.add_char b s.[i] ;
+        scan (i + 1) )
+  in
+  scan 0 ; Buffer.contents b
+
+(* the shallowest proof, and the deepest failure *)
+let merge e e' =
+  { script=
+      ( match (e.script, e'.script) with
+      | Some (_, d), Some (_, d') when Int.( < ) d' d -> e'.script
+      | None, script -> script
+      | script, _ -> script )
+  ; failed= Int.max e.failed e'.failed }
+
+let read_file () : (string, entry) Hashtbl.t =
+  match open_in_bin !path with
+  | exception Sys_error _ -> Hashtbl.create 53
+  | ic ->
+      let table =
+        try (Marshal.from_channel ic : (string, entry) Hashtbl.t)
+        with End_of_file | Failure _ -> Hashtbl.create 53
+      in
+      close_in ic ; table
+
+(* entries recorded by this process, still to be written out *)
+let recorded : (string, entry) Hashtbl.t = Hashtbl.create 53
+
+let save () =
+  if enabled () && Int.( > ) (Hashtbl.length recorded) 0 then (
+    (* other runs may have written to the file since it was read *)
+    let table = read_file () in
+    Hashtbl.iter
+      (fun k e ->
+        Hashtbl.replace table k
+          (Option.dest e (merge e) (Hashtbl.find_opt table k)) )
+      recorded ;
+    let tmp = !path ^ "." ^ string_of_int (Unix.getpid ()) in
+    let oc = open_out_bin tmp in
+    Marshal.to_channel oc table [] ;
+    close_out oc ;
+    Sys.rename tmp !path ;
+    Hashtbl.reset recorded )
+
+let loaded = ref None
+
+let table () =
+  match !loaded with
+  | Some table -> table
+  | None ->
+      let table = read_file () in
+      let owner = Unix.getpid () in
+      loaded := Some table ;
+      (* processes forked by the searches exit too *)
+      at_exit (fun () -> if Int.equal (Unix.getpid ()) owner then save ()) ;
+      table
+
+let key k = Digest.to_hex (Digest.string (!context ^ "\n" ^ k))
+
+let find k = Hashtbl.find_opt (table ()) (key k)
+
+let update k e' =
+  let k = key k in
+  let table = table () in
+  let e = merge (Option.dest no_entry Fun.id (Hashtbl.find_opt table k)) e' in
+  Hashtbl.replace table k e ;
+  Hashtbl.replace recorded k e
+
+let record_proof k script depth =
+  update k {no_entry with script= Some (script, depth)}
+
+let record_failure k bound = update k {no_entry with failed= bound}
@@ -0,0 +1,42 @@
+(** An on-disk store of the outcomes of proof searches, so that sequents
+    proved, or searched for in vain, in earlier runs need not be searched for
+    again.
+
+    Entries are keyed by strings, normally a printed sequent whose variables
+    and tags have been renamed by [normalise].  Proofs are recorded as the
+    scripts of [Prover.script], since the terms they consist of are
+    hash-consed and cannot be stored; a script must therefore be replayed, and
+    the result checked, before it is trusted. *)
+
+type entry =
+  { script: (int list * int) option
+        (** A script rebuilding a proof, and the depth it was found at. *)
+  ; failed: int
+        (** The largest maximum depth at which a complete search failed,
+            [-1] if none. *) }
+
+val path : string ref
+(** The file backing the store; the empty string disables it. *)
+
+val context : string ref
+(** Prefixed to every key, so that front-ends can keep apart the outcomes
+    obtained under e.g. different sets of inductive definitions. *)
+
+val enabled : unit -> bool
+
+val normalise : string list -> string -> string
+(** [normalise names s] renames each identifier in [s] that is one of
+    [names], and is not followed by a bracket, to a canonical one, in order
+    of first occurrence.  A trailing quote, marking an existential, is kept. *)
+
+val find : string -> entry option
+
+val record_proof : string -> int list -> int -> unit
+(** [record_proof key script depth] records a proof found at [depth]. *)
+
+val record_failure : string -> int -> unit
+(** [record_failure key bound] records that no proof exists up to [bound]. *)
+
+val save : unit -> unit
+(** Merge the entries recorded since the store was loaded into the file
+    backing it.  Called on exit by the process that loaded the store. *)
@@ -67,10 +67,28 @@ module type S = sig
 
   val get_ancestry : int -> t -> (int * node_t) list
 
+  val ancestors : int -> t -> int list
+  (** [ancestors idx prf] returns the indices of the nodes on the path from
+      the root to [idx], inclusive, like [get_ancestry] but without the
+      nodes. *)
+
+  val candidates_upto_tags : int -> t -> int list
+  (** [candidates_upto_tags idx prf] returns the indices of the nodes other
+      than [idx] whose sequents may be equal, up to tags, to that of [idx].
+      These are found through an index on [Seq.hash_upto_tags] maintained by
+      the constructors, so all such nodes are returned but some may not be
+      equal after all. *)
+
+  val fold : (int -> node_t -> 'a -> 'a) -> t -> 'a -> 'a
+  (** Fold over the nodes in increasing index order. *)
+
   val is_closed_at : t -> int -> bool
 
   val check : t -> bool
-  (** Check soundness. Proof does not need to be closed. *)
+  (** Check soundness. Proof does not need to be closed. The abstract view
+      used by {!Soundcheck}, and the set of nodes its minimisation keeps, are
+      maintained by the constructors, so only the part of the proof that
+      survives minimisation is looked at here. *)
 
   val is_closed : t -> bool
   (** Are all nodes not open? *)
@@ -88,25 +106,43 @@ module Make (Seq : Sequent.S) = struct
   module Node = Proofnode.Make (Seq)
   module P = Int.Map
 
-  type t = (int * Node.t) P.t
+  (* Alongside the nodes (each paired with the index of its parent) we keep
+     the abstract view handed to [Soundcheck], updated node by node as the
+     proof is extended so that a soundness check never has to convert the
+     whole proof, and the nodes indexed by the hash of their sequents up to
+     tags, so that back-link targets can be found without a scan.
+
+     We also keep the [live] nodes, from which an infinite path starts: these
+     are the non-root nodes that minimisation keeps, so a soundness check
+     only looks at them.  Only a back-link can make nodes live, namely its
+     source and the nodes reaching it, so with the back-links into each node
+     kept in [backlinks_to] these are found by walking back from the source
+     through nodes that are not live yet. *)
+  type t =
+    { nodes: (int * Node.t) P.t
+    ; abs: Soundcheck.t
+    ; by_seq: Int.Set.t P.t
+    ; live: Int.Set.t
+    ; backlinks_to: Int.Set.t P.t }
 
   type seq_t = Seq.t
 
   type node_t = Node.t
 
-  let get idx prf = P.find idx prf
+  let get idx prf = P.find idx prf.nodes
 
   let find idx prf = snd (get idx prf)
 
   let get_seq idx prf = Node.get_seq (find idx prf)
 
-  let fresh_idx prf = 1 + fst (P.max_binding prf)
+  let fresh_idx prf = 1 + fst (P.max_binding prf.nodes)
 
   let fresh_idxs xs prf = Blist.range (fresh_idx prf) xs
 
-  let to_list m = Blist.map (fun (i, (_, n)) -> (i, n)) (P.bindings m)
+  let to_list prf =
+    Blist.map (fun (i, (_, n)) -> (i, n)) (P.bindings prf.nodes)
 
-  let size prf = P.cardinal prf
+  let size prf = P.cardinal prf.nodes
 
   let num_backlinks prf =
     Blist.length
@@ -127,16 +163,40 @@ module Make (Seq : Sequent.S) = struct
 
   let to_string prf = mk_to_string pp prf
 
-  let is_closed prf = P.for_all (fun _ (_, n) -> not (Node.is_open n)) prf
+  let is_closed prf =
+    P.for_all (fun _ (_, n) -> not (Node.is_open n)) prf.nodes
 
   let check p =
     let () = debug (fun _ -> "Checking global soundness") in
     let () = debug (fun _ -> to_string p) in
-    Soundcheck.check_proof (P.map (fun (_, n) -> Node.to_abstract_node n) p)
+    Soundcheck.check_live_proof p.abs p.live
+
+  (* a node replacing another keeps its sequent, so only new nodes need *)
+  (* indexing *)
+  let add_node idx par n prf =
+    let by_seq =
+      if P.mem idx prf.nodes then prf.by_seq
+      else
+        P.update
+          (Seq.hash_upto_tags (Node.get_seq n))
+          (fun idxs ->
+            Some (Int.Set.add idx (Option.dest Int.Set.empty Fun.id idxs)) )
+          prf.by_seq
+    in
+    { prf with
+      nodes= P.add idx (par, n) prf.nodes
+    ; abs= P.add idx (Node.to_abstract_node n) prf.abs
+    ; by_seq }
 
-  let mk seq = P.add 0 (0, Node.mk_open seq) P.empty
+  let mk seq =
+    add_node 0 0 (Node.mk_open seq)
+      { nodes= P.empty
+      ; abs= P.empty
+      ; by_seq= P.empty
+      ; live= Int.Set.empty
+      ; backlinks_to= P.empty }
 
-  let replace idx n prf = P.add idx (fst (get idx prf), n) prf
+  let replace idx n prf = add_node idx (fst (get idx prf)) n prf
 
   let ensure_add idx n prf =
     let n' = find idx prf in
@@ -146,12 +206,46 @@ module Make (Seq : Sequent.S) = struct
     let n = Node.mk_axiom (get_seq idx prf) descr in
     ensure_add idx n prf ; replace idx n prf
 
+  (* the nodes that are not live and reach [idx] through such nodes only *)
+  let reaching idx prf =
+    let preds x =
+      let par = fst (get x prf) in
+      let bls =
+        Option.dest Int.Set.empty Fun.id (P.find_opt x prf.backlinks_to)
+      in
+      if Int.equal par x then bls else Int.Set.add par bls
+    in
+    let rec aux found = function
+      | [] -> found
+      | x :: xs ->
+          if Int.Set.mem x found || Int.Set.mem x prf.live then aux found xs
+          else aux (Int.Set.add x found) (Int.Set.fold Blist.cons (preds x) xs)
+    in
+    aux Int.Set.empty [idx]
+
+  (* The source of a back-link is open, so not live before.  It becomes *)
+  (* live if its target is live or now reaches it, and then so do the *)
+  (* nodes reaching it; those that are not live yet reach it through nodes *)
+  (* that are not live either, as all nodes reachable from them are dead. *)
   let add_backlink idx descr target vtts prf =
     let seq = get_seq idx prf in
     let n = Node.mk_backlink seq descr target vtts in
     ensure_add idx n prf ;
     assert (Seq.equal_upto_tags seq (get_seq target prf)) ;
-    replace idx n prf
+    let prf = replace idx n prf in
+    let reach = reaching idx prf in
+    let live =
+      if Int.Set.mem target prf.live || Int.Set.mem target reach then
+        Int.Set.union prf.live reach
+      else prf.live
+    in
+    let backlinks_to =
+      P.update target
+        (fun idxs ->
+          Some (Int.Set.add idx (Option.dest Int.Set.empty Fun.id idxs)) )
+        prf.backlinks_to
+    in
+    {prf with live; backlinks_to}
 
   let add_inf idx descr subgoals prf =
     let subidxs = Blist.range (fresh_idx prf) subgoals in
@@ -163,7 +257,7 @@ module Make (Seq : Sequent.S) = struct
     ensure_add idx n prf ;
     let prf' =
       Blist.foldl
-        (fun prf' (ci, cn) -> P.add ci (idx, cn) prf')
+        (fun prf' (ci, cn) -> add_node ci idx cn prf')
         (replace idx n prf) subnodes
     in
     (subidxs, prf')
@@ -246,6 +340,21 @@ module Make (Seq : Sequent.S) = struct
     in
     aux [] idx (get idx prf)
 
+  let ancestors idx prf =
+    let rec aux acc idx =
+      let par_idx = fst (get idx prf) in
+      let acc = idx :: acc in
+      if Int.equal par_idx idx then acc else aux acc par_idx
+    in
+    aux [] idx
+
+  let candidates_upto_tags idx prf =
+    match P.find_opt (Seq.hash_upto_tags (get_seq idx prf)) prf.by_seq with
+    | None -> []
+    | Some idxs -> Int.Set.elements (Int.Set.remove idx idxs)
+
+  let fold f prf acc = P.fold (fun idx (_, n) acc -> f idx n acc) prf.nodes acc
+
   let rec is_closed_at prf idx =
     let n = find idx prf in
     if Node.is_axiom n then true
@@ -69,10 +69,27 @@ module type S = sig
 
   val get_ancestry : int -> t -> (int * node_t) list
 
+  val ancestors : int -> t -> int list
+  (** [ancestors idx prf] returns the indices of the nodes on the path from
+      the root to [idx], inclusive, like [get_ancestry] but without the
+      nodes. *)
+
+  val candidates_upto_tags : int -> t -> int list
+  (** [candidates_upto_tags idx prf] returns the indices of the nodes other
+      than [idx] whose sequents may be equal, up to tags, to that of [idx].
+      These are found through an index on [Seq.hash_upto_tags] maintained by
+      the constructors, so all such nodes are returned but some may not be
+      equal after all. *)
+
+  val fold : (int -> node_t -> 'a -> 'a) -> t -> 'a -> 'a
+  (** Fold over the nodes in increasing index order. *)
+
   val is_closed_at : t -> int -> bool
 
   val check : t -> bool
-  (** Check soundness. Proof does not need to be closed. *)
+  (** Check soundness. Proof does not need to be closed. The abstract view
+      used by {!Soundcheck} is maintained by the constructors, so no
+      conversion of the proof takes place here. *)
 
   val is_closed : t -> bool
   (** Are all nodes not open? *)
@@ -0,0 +1,246 @@
+open Lib
+
+exception Error of int * string
+
+(* Identifiers are interned by hashing them in place in the input, so that
+   no substring is ever allocated: the table only records where in the input
+   a name was first seen.  Tables are emptied in constant time by bumping a
+   generation stamp, so that parsing many small proofs stays cheap. *)
+module Names = struct
+  type t =
+    { mutable src: string
+    ; mutable stamp: int
+    ; mutable count: int
+    ; mutable gens: int array
+    ; mutable offs: int array
+    ; mutable lens: int array
+    ; mutable ids: int array }
+
+  let create n =
+    { src= ""
+    ; stamp= 1
+    ; count= 0
+    ; gens= Array.make n 0
+    ; offs= Array.make n 0
+    ; lens= Array.make n 0
+    ; ids= Array.make n 0 }
+
+  let reset t src =
+    t.src <- src ;
+    t.stamp <- t.stamp + 1 ;
+    t.count <- 0
+
+  let hash s ofs len =
+    let h = ref 0 in
+    for i = ofs to ofs + len - 1 do
+      h := (31 * !h) + Char.code (String.unsafe_get s i)
+    done ;
+    !h land max_int
+
+  let same s ofs ofs' len =
+    let rec aux i =
+      Int.( >= ) i len
+      || Char.equal
+           (String.unsafe_get s (ofs + i))
+           (String.unsafe_get s (ofs' + i))
+         && aux (i + 1)
+    in
+    aux 0
+
+  let insert t ofs len id =
+    let mask = Array.length t.gens - 1 in
+    let rec probe i =
+      if Int.equal t.gens.(i) t.stamp then probe ((i + 1) land mask)
+      else (
+        t.gens.(i) <- t.stamp ;
+        t.offs.(i) <- ofs ;
+        t.lens.(i) <- len ;
+        t.ids.(i) <- id )
+    in
+    probe (hash t.src ofs len land mask)
+
+  let grow t =
+    let n = Array.length t.gens in
+    let gens, offs, lens, ids = (t.gens, t.offs, t.lens, t.ids) in
+    t.gens <- Array.make (2 * n) 0 ;
+    t.offs <- Array.make (2 * n) 0 ;
+    t.lens <- Array.make (2 * n) 0 ;
+    t.ids <- Array.make (2 * n) 0 ;
+    for i = 0 to n - 1 do
+      if Int.equal gens.(i) t.stamp then insert t offs.(i) lens.(i) ids.(i)
+    done
+
+  let intern t ofs len =
+    let mask = Array.length t.gens - 1 in
+    let rec probe i =
+      if not (Int.equal t.gens.(i) t.stamp) then (
+        let id = t.count in
+        t.gens.(i) <- t.stamp ;
+        t.offs.(i) <- ofs ;
+        t.lens.(i) <- len ;
+        t.ids.(i) <- id ;
+        t.count <- id + 1 ;
+        if Int.( > ) (2 * t.count) (Array.length t.gens) then grow t ;
+        id )
+      else if Int.equal t.lens.(i) len && same t.src t.offs.(i) ofs len then
+        t.ids.(i)
+      else probe ((i + 1) land mask)
+    in
+    probe (hash t.src ofs len land mask)
+end
+
+let node_names = Names.create 256
+
+let tag_names = Names.create 256
+
+(* Tags and premises of the nodes of the proof being parsed, indexed by the
+   interned node identifiers. *)
+let nodes = ref (Array.make 256 (Int.Set.empty, []))
+
+let get_node id =
+  if Int.( >= ) id (Array.length !nodes) then (
+    let nodes' = Array.make (2 * id) (Int.Set.empty, []) in
+    Array.blit !nodes 0 nodes' 0 (Array.length !nodes) ;
+    nodes := nodes' ) ;
+  !nodes.(id)
+
+let clear_nodes () =
+  Array.fill !nodes 0 node_names.Names.count (Int.Set.empty, [])
+
+type state = {src: string; mutable pos: int; stop: int}
+
+let fail st what = raise (Error (st.pos, what))
+
+let peek st =
+  if Int.( < ) st.pos st.stop then String.unsafe_get st.src st.pos else '\000'
+
+let rec skip_spaces st =
+  match peek st with
+  | ' ' | '\t' | '\n' | '\r' ->
+      st.pos <- st.pos + 1 ;
+      skip_spaces st
+  | _ -> ()
+
+let expect st c =
+  skip_spaces st ;
+  if Char.equal (peek st) c then st.pos <- st.pos + 1
+  else fail st (Printf.sprintf "'%c'" c)
+
+let is_id_char = function
+  | '_' | '0' .. '9' | 'a' .. 'z' | 'A' .. 'Z' | '\'' | '.' | '-' -> true
+  | _ -> false
+
+(* a '-' is part of an identifier unless it starts an arrow *)
+let ident names st =
+  skip_spaces st ;
+  let rec scan i =
+    if
+      Int.( < ) i st.stop
+      && is_id_char (String.unsafe_get st.src i)
+      && not
+           ( Char.equal (String.unsafe_get st.src i) '-'
+           && Int.( < ) (i + 1) st.stop
+           && Char.equal (String.unsafe_get st.src (i + 1)) '>' )
+    then scan (i + 1)
+    else i
+  in
+  let start = st.pos in
+  let stop = scan start in
+  if Int.equal start stop then fail st "identifier" ;
+  st.pos <- stop ;
+  Names.intern names start (stop - start)
+
+let node st =
+  let id = ident node_names st in
+  ignore (get_node id) ;
+  id
+
+let arrow st =
+  skip_spaces st ;
+  if
+    Int.( < ) (st.pos + 1) st.stop
+    && Char.equal (String.unsafe_get st.src st.pos) '-'
+    && Char.equal (String.unsafe_get st.src (st.pos + 1)) '>'
+  then st.pos <- st.pos + 2
+  else fail st "'->'"
+
+(* parses a braced list of tag pairs onto [acc] *)
+let tagpairs st acc =
+  let rec pairs acc =
+    expect st '(' ;
+    let t = ident tag_names st in
+    expect st ',' ;
+    let t' = ident tag_names st in
+    expect st ')' ;
+    let acc = (t, t') :: acc in
+    skip_spaces st ;
+    if Char.equal (peek st) ',' then (
+      st.pos <- st.pos + 1 ;
+      pairs acc )
+    else (expect st '}' ; acc)
+  in
+  expect st '{' ;
+  skip_spaces st ;
+  if Char.equal (peek st) '}' then (
+    st.pos <- st.pos + 1 ;
+    acc )
+  else pairs acc
+
+let line st =
+  let src = node st in
+  arrow st ;
+  let dest = node st in
+  expect st ':' ;
+  let prog = tagpairs st [] in
+  expect st ',' ;
+  let all = tagpairs st prog in
+  let src_tags, premises = get_node src in
+  if Blist.exists (fun (i, _, _) -> Int.equal i dest) premises then
+    fail st "a premise not listed before" ;
+  !nodes.(src) <-
+    ( Blist.fold_left (fun ts (t, _) -> Int.Set.add t ts) src_tags all
+    , (dest, all, prog) :: premises ) ;
+  let dest_tags, premises = get_node dest in
+  !nodes.(dest) <-
+    (Blist.fold_left (fun ts (_, t) -> Int.Set.add t ts) dest_tags all, premises)
+
+let parse src pos stop =
+  let st = {src; pos; stop} in
+  let rec lines () =
+    skip_spaces st ;
+    if Int.( >= ) st.pos st.stop then ()
+    else if Char.equal (peek st) ';' then st.pos <- st.pos + 1
+    else (line st ; lines ())
+  in
+  Names.reset node_names src ;
+  Names.reset tag_names src ;
+  (try lines () with e -> clear_nodes () ; raise e) ;
+  let rec build prf id =
+    if Int.( < ) id 0 then prf
+    else
+      let tags, premises = !nodes.(id) in
+      build (Int.Map.add id (Soundcheck.build_node tags premises) prf) (id - 1)
+  in
+  let prf = build Int.Map.empty (node_names.Names.count - 1) in
+  clear_nodes () ;
+  ((prf, 0), st.pos)
+
+let of_string s =
+  let stop = String.length s in
+  let res, pos = parse s 0 stop in
+  let st = {src= s; pos; stop} in
+  skip_spaces st ;
+  if Int.( < ) st.pos stop then fail st "end of input" ;
+  res
+
+let fold f a s =
+  let stop = String.length s in
+  let rec aux a pos =
+    let st = {src= s; pos; stop} in
+    skip_spaces st ;
+    if Int.( >= ) st.pos stop then a
+    else
+      let res, pos = parse s st.pos stop in
+      aux (f a res) pos
+  in
+  aux a 0
@@ -0,0 +1,29 @@
+(** A fast, hand-written parser for the textual proof format read by
+    [checkproof], building abstract proofs (see {!Soundcheck}) directly.
+
+    A proof is a sequence of lines of the form
+
+    [<node-id> -> <node-id> : { <tag-pair-list> }, { <tag-pair-list> }]
+
+    terminated by [';'], where the first list holds the progressing tag
+    pairs and the second the remaining (non-progressing) ones. Node and tag
+    identifiers are mapped to integers in order of first occurrence within
+    each proof, so the initial node, i.e. the source of the first line, is
+    always node 0. *)
+
+exception Error of int * string
+(** Raised with the offset in the input where parsing failed and a
+    description of what was expected there. *)
+
+val parse : string -> int -> int -> (Soundcheck.t * int) * int
+(** [parse s pos stop] parses a single proof from [s], starting at offset
+    [pos] and not reading at or beyond [stop]. It returns the proof paired
+    with its initial node, and the offset just after the terminating [';'],
+    or [stop] if the input ended before one was found. *)
+
+val of_string : string -> Soundcheck.t * int
+(** Parse a string containing a single proof, with the terminating [';']
+    being optional. *)
+
+val fold : ('a -> Soundcheck.t * int -> 'a) -> 'a -> string -> 'a
+(** [fold f a s] folds [f] over all the proofs in [s], in order. *)
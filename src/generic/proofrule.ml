@@ -27,17 +27,19 @@ module type S = sig
   **)
   type t = int -> proof_t -> (int list * proof_t) Blist.t
 
-  val mk_axiom : axiom_f -> t
+  val mk_axiom : ?name:string -> axiom_f -> t
   (** Axioms are modeled as functions that return [Some string] when the
       input sequent is an instance of an axiom described by [string], else
-      [None]. *)
+      [None].  When rules are profiled, those of the same [name] share a row,
+      and a rule with no [name] is filed under the description of the first
+      application it produces. *)
 
-  val mk_infrule : infrule_f -> t
+  val mk_infrule : ?name:string -> infrule_f -> t
   (** Rules are functions that break down a sequent to a choice of applications
       where each application is a list of premises, including tag information,
-      and a description. *)
+      and a description.  [name] is as for [mk_axiom]. *)
 
-  val mk_backrule : bool -> select_f -> backrule_f -> t
+  val mk_backrule : ?name:string -> bool -> select_f -> backrule_f -> t
   (** Backlink rules take:
       - a boolean [eager]
       - a selection function [s]
@@ -55,6 +57,7 @@ module type S = sig
       If [eager] is true then the first result in this iteration will be chosen
       and no back-tracking will even happen over later possible matches.
       Otherwise all possible matches are returned as different choices.
+      [name] is as for [mk_axiom].
       *)
 
   val all_nodes : select_f
@@ -66,6 +69,10 @@ module type S = sig
 
   val syntactically_equal_nodes : select_f
 
+  val equal_upto_tags_nodes : select_f
+  (** The nodes whose sequents are equal to the current one up to tags, i.e.
+      exactly those [Proof.add_backlink] accepts as targets. *)
+
   val fail : t
   (** The rule that always fails. *)
 
@@ -75,17 +82,20 @@ module type S = sig
   val attempt : t -> t
   (** Try a rule and if it fails act as [identity]. *)
 
-  val compose : t -> t -> t
-  (** Apply the second rule on all premises generated by applying the first. *)
+  val compose : ?name:string -> t -> t -> t
+  (** Apply the second rule on all premises generated by applying the first.
+      This and the other combinators taking a [name] are profiled under it,
+      and not at all without one, as the applications they produce are
+      described by the rules they combine. *)
 
   val compose_pairwise : t -> t list -> t
   (** Apply the list of rules in the second argument in a pairwise fashion to
       the premises generated by applying the first rule *)
 
-  val choice : t list -> t
+  val choice : ?name:string -> t list -> t
   (** Apply a list of rules on current subgoal and return all applications. *)
 
-  val first : t list -> t
+  val first : ?name:string -> t list -> t
   (** Try rules from a list until the first rule is found that has some
       applications on current sugboal and return only those. *)
 
@@ -117,6 +127,32 @@ module Make (Seq : Sequent.S) = struct
 
   type select_f = int -> Proof.t -> int list
 
+  (* When profiling, record calls of a rule under its [name], or else under *)
+  (* the description of the first application it ever produces *)
+  let profiled ?name kind rule =
+    let descr = ref name in
+    fun idx prf ->
+      if not !Stats.Rules.enabled then rule idx prf
+      else
+        let checks = !Stats.Rules.soundness_checks in
+        let start = Stats.now () in
+        let apps = rule idx prf in
+        let time = Stats.time_since start in
+        let () =
+          match (!descr, apps) with
+          | None, (_, prf') :: _ ->
+              descr := Some (snd (Node.dest (Proof.find idx prf')))
+          | _ -> ()
+        in
+        Stats.Rules.record
+          (Option.dest ("(unidentified " ^ kind ^ ")") Fun.id !descr)
+          ~apps:(L.length apps)
+          ~subgoals:
+            (L.fold_left (fun n (subgoals, _) -> n + L.length subgoals) 0 apps)
+          ~checks:(!Stats.Rules.soundness_checks - checks)
+          time ;
+        apps
+
   (* Apply the sequent in the open node identified by idx in prf to the
 	   characterising function ax_f.
 		   If we get back Some descr then the sequent is the conclusion of the axiom
@@ -126,58 +162,69 @@ module Make (Seq : Sequent.S) = struct
 			   since axioms do not have any premises.
 		   Otherwise return an empty list of results
 	*)
-  let mk_axiom ax_f idx prf =
-    match ax_f (Proof.get_seq idx prf) with
-    | None -> L.empty
-    | Some descr -> L.singleton ([], Proof.add_axiom idx descr prf)
-
-  let mk_infrule r_f idx prf =
-    let seq = Proof.get_seq idx prf in
-    let mk (l, d) =
-      debug (fun () -> "Found " ^ d ^ " app.") ;
-      Proof.add_inf idx d l prf
-    in
-    L.map mk (L.of_list (r_f seq))
-
-  let mk_backrule greedy sel_f br_f srcidx prf =
-    let srcseq = Proof.get_seq srcidx prf in
-    let trgidxs = L.of_list (sel_f srcidx prf) in
-    let mk trgidx (vtts, d) =
-      ([], Proof.add_backlink srcidx d trgidx vtts prf)
-    in
-    let check (_, p) = Proof.check p in
-    let apply trgidx =
-      let trgseq = Proof.get_seq trgidx prf in
-      L.map (mk trgidx) (L.of_list (br_f srcseq trgseq))
-    in
-    let apps = L.bind apply trgidxs in
-    if greedy then Option.dest L.empty L.singleton (L.find_opt check apps)
-    else L.filter check apps
+  let mk_axiom ?name ax_f =
+    profiled ?name "axiom" (fun idx prf ->
+        match ax_f (Proof.get_seq idx prf) with
+        | None -> L.empty
+        | Some descr -> L.singleton ([], Proof.add_axiom idx descr prf) )
+
+  let mk_infrule ?name r_f =
+    profiled ?name "inference rule" (fun idx prf ->
+        let seq = Proof.get_seq idx prf in
+        let mk (l, d) =
+          debug (fun () -> "Found " ^ d ^ " app.") ;
+          Proof.add_inf idx d l prf
+        in
+        L.map mk (L.of_list (r_f seq)) )
+
+  let mk_backrule ?name greedy sel_f br_f =
+    profiled ?name "back-link rule" (fun srcidx prf ->
+        let srcseq = Proof.get_seq srcidx prf in
+        let trgidxs = L.of_list (sel_f srcidx prf) in
+        let mk trgidx (vtts, d) =
+          ([], Proof.add_backlink srcidx d trgidx vtts prf)
+        in
+        let check (_, p) =
+          incr Stats.Rules.soundness_checks ;
+          Proof.check p
+        in
+        let apply trgidx =
+          let trgseq = Proof.get_seq trgidx prf in
+          L.map (mk trgidx) (L.of_list (br_f srcseq trgseq))
+        in
+        let apps = L.bind apply trgidxs in
+        if greedy then Option.dest L.empty L.singleton (L.find_opt check apps)
+        else L.filter check apps )
 
   let all_nodes srcidx prf =
-    Blist.filter
-      (fun idx -> not (Int.equal idx srcidx))
-      (Blist.map fst (Proof.to_list prf))
+    Blist.rev
+      (Proof.fold
+         (fun idx _ idxs ->
+           if Int.equal idx srcidx then idxs else idx :: idxs )
+         prf [])
 
   let closed_nodes srcidx prf =
-    let nodes =
-      Blist.filter
-        (fun (idx, n) -> (not (Node.is_open n)) && not (Int.equal idx srcidx))
-        (Proof.to_list prf)
-    in
-    Blist.map fst nodes
+    Blist.rev
+      (Proof.fold
+         (fun idx n idxs ->
+           if Node.is_open n || Int.equal idx srcidx then idxs
+           else idx :: idxs )
+         prf [])
 
-  let ancestor_nodes srcidx prf = Blist.map fst (Proof.get_ancestry srcidx prf)
+  let ancestor_nodes srcidx prf = Proof.ancestors srcidx prf
 
+  let equal_upto_tags_nodes srcidx prf =
+    let seq = Proof.get_seq srcidx prf in
+    Blist.filter
+      (fun idx -> Seq.equal_upto_tags seq (Proof.get_seq idx prf))
+      (Proof.candidates_upto_tags srcidx prf)
+
+  (* [Seq.equal] implies [Seq.equal_upto_tags], so the index applies *)
   let syntactically_equal_nodes srcidx prf =
     let seq = Proof.get_seq srcidx prf in
-    let nodes =
-      Blist.filter
-        (fun (idx, n) ->
-          Seq.equal seq (Node.get_seq n) && not (Int.equal idx srcidx) )
-        (Proof.to_list prf)
-    in
-    Blist.map fst nodes
+    Blist.filter
+      (fun idx -> Seq.equal seq (Proof.get_seq idx prf))
+      (Proof.candidates_upto_tags srcidx prf)
 
   let fail _ _ = L.empty
 
@@ -213,25 +260,34 @@ module Make (Seq : Sequent.S) = struct
         rules subgoals
     with Invalid_argument _ -> L.empty
 
-  let compose r r' idx prf =
-    L.bind
-      (fun ((subgoals, _) as res) ->
-        apply_to_subgoals_pairwise
-          (Blist.repeat r' (Blist.length subgoals))
-          res )
-      (r idx prf)
+  (* the applications of a combinator are described by the rules it *)
+  (* combines, so only one given a name is profiled *)
+  let named name rule = Option.dest rule (fun _ -> profiled ?name "" rule) name
+
+  let compose ?name r r' =
+    named name (fun idx prf ->
+        L.bind
+          (fun ((subgoals, _) as res) ->
+            apply_to_subgoals_pairwise
+              (Blist.repeat r' (Blist.length subgoals))
+              res )
+          (r idx prf) )
 
   let compose_pairwise r rs idx prf =
     L.bind (apply_to_subgoals_pairwise rs) (r idx prf)
 
-  let choice rl idx prf = L.bind (fun f -> f idx prf) (L.of_list rl)
+  let choice ?name rl =
+    named name (fun idx prf -> L.bind (fun f -> f idx prf) (L.of_list rl))
 
-  let rec first rl idx prf =
-    match rl with
-    | [] -> L.empty
-    | r :: rs ->
-        let apps = r idx prf in
-        if not (L.is_empty apps) then apps else first rs idx prf
+  let first ?name rl =
+    let rec first rl idx prf =
+      match rl with
+      | [] -> L.empty
+      | r :: rs ->
+          let apps = r idx prf in
+          if not (L.is_empty apps) then apps else first rs idx prf
+    in
+    named name (first rl)
 
   let identity idx prf = L.singleton ([idx], prf)
 
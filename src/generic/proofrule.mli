@@ -26,17 +26,19 @@ module type S = sig
   **)
   type t = int -> proof_t -> (int list * proof_t) Blist.t
 
-  val mk_axiom : axiom_f -> t
+  val mk_axiom : ?name:string -> axiom_f -> t
   (** Axioms are modeled as functions that return [Some string] when the
       input sequent is an instance of an axiom described by [string], else
-      [None]. *)
+      [None].  When rules are profiled, those of the same [name] share a row,
+      and a rule with no [name] is filed under the description of the first
+      application it produces. *)
 
-  val mk_infrule : infrule_f -> t
+  val mk_infrule : ?name:string -> infrule_f -> t
   (** Rules are functions that break down a sequent to a choice of applications
       where each application is a list of premises, including tag information,
-      and a description. *)
+      and a description.  [name] is as for [mk_axiom]. *)
 
-  val mk_backrule : bool -> select_f -> backrule_f -> t
+  val mk_backrule : ?name:string -> bool -> select_f -> backrule_f -> t
   (** Backlink rules take:
       - a boolean [eager]
       - a selection function [s]
@@ -54,6 +56,7 @@ module type S = sig
       If [eager] is true then the first result in this iteration will be chosen
       and no back-tracking will even happen over later possible matches.
       Otherwise all possible matches are returned as different choices.
+      [name] is as for [mk_axiom].
       *)
 
   val all_nodes : select_f
@@ -65,6 +68,10 @@ module type S = sig
 
   val syntactically_equal_nodes : select_f
 
+  val equal_upto_tags_nodes : select_f
+  (** The nodes whose sequents are equal to the current one up to tags, i.e.
+      exactly those [Proof.add_backlink] accepts as targets. *)
+
   val fail : t
   (** The rule that always fails. *)
 
@@ -74,17 +81,20 @@ module type S = sig
   val attempt : t -> t
   (** Try a rule and if it fails act as [identity]. *)
 
-  val compose : t -> t -> t
-  (** Apply the second rule on all premises generated by applying the first. *)
+  val compose : ?name:string -> t -> t -> t
+  (** Apply the second rule on all premises generated by applying the first.
+      This and the other combinators taking a [name] are profiled under it,
+      and not at all without one, as the applications they produce are
+      described by the rules they combine. *)
 
   val compose_pairwise : t -> t list -> t
   (** Apply the list of rules in the second argument in a pairwise fashion to
       the premises generated by applying the first rule *)
 
-  val choice : t list -> t
+  val choice : ?name:string -> t list -> t
   (** Apply a list of rules on current subgoal and return all applications. *)
 
-  val first : t list -> t
+  val first : ?name:string -> t list -> t
   (** Try rules from a list until the first rule is found that has some
       applications on current sugboal and return only those. *)
 
@@ -11,9 +11,96 @@ module type S = sig
 
   val last_search_depth : int ref
 
+  val transpositions : bool ref
+  (** Whether [idfs] keeps a transposition table across depth iterations.
+      A sequent that failed to close with some remaining depth is not
+      searched again with at most that depth, and a sound, closed subproof
+      of a sequent is reused instead of being searched for anew.  As back-links
+      make the outcome of a search depend on the ancestors of a node, the
+      former may cause proofs to be missed. *)
+
+  val nogoods : bool ref
+  (** Whether [idfs] keeps the failures of the transposition table, even
+      without [transpositions], and matches sequents against it only up to
+      tags, so that a sequent that could not be closed with some remaining
+      depth fails at once on meeting it again, tags aside, with at most that
+      depth.  As with [transpositions], back-links may make this miss
+      proofs. *)
+
+  val jobs : int ref
+  (** Number of worker processes [idfs] farms the alternative rule
+      applications at the root out to; [1] searches sequentially.  The first
+      worker to close its branch wins and the rest are killed, so the proof
+      found need not be the one a sequential search finds first.  The
+      workers keep no table, whatever [transpositions] and [nogoods], and
+      the branches of a worker that dies are taken to fail. *)
+
+  val checkpoint : string ref
+  (** A file [idfs] saves its progress to when interrupted by [Timeout], and
+      resumes from when searching for the same sequent again; the empty
+      string disables this.  The progress is the depth bound reached and,
+      unless the root is searched in parallel, the first alternative rule
+      application at the root not yet exhausted at that bound.  It is kept
+      per sequent, and dropped once the search for it completes.  Caches
+      such as the transposition table hold hash-consed sequents and are not
+      saved. *)
+
   val idfs : int -> int -> rule_t -> rule_t -> Seq.t -> Proof.t option
 
-  (* val bfs : int -> rule_t -> rule_t -> Seq.t -> Proof.t option   *)
+  type heuristic_t = Proof.t -> int list -> int
+  (** A heuristic scores a partial proof and its open goals; lower scores are
+      expanded first. *)
+
+  val heuristics : (string * heuristic_t) list
+  (** The available heuristics, by name:
+      - ["goals"] counts the open goals;
+      - ["size"] sums the [Seq.size] of the open sequents;
+      - ["preds"] sums the numbers of tags, i.e. of inductive predicates, in
+        the open sequents;
+      - ["backlinks"] counts the open goals without an ancestor equal up to
+        tags, i.e. an obvious back-link candidate. *)
+
+  val best_first :
+    int -> heuristic_t -> rule_t -> rule_t -> Seq.t -> Proof.t option
+  (** [best_first maxbound h ax r seq] searches for a proof of [seq] by
+      always expanding the first open goal of the partial proof with the
+      lowest score under [h].  Goals deeper than [maxbound] are abandoned. *)
+
+  val bfs_frontier_cap : int ref
+  (** Maximum number of partial proofs [bfs] keeps queued. *)
+
+  val bfs : int -> int -> rule_t -> rule_t -> Seq.t -> Proof.t option
+  (** [bfs minbound maxbound ax r seq] searches breadth-first, expanding the
+      partial proofs whose next open goal is shallowest first.  Should the
+      frontier outgrow [!bfs_frontier_cap] it falls back to
+      [idfs minbound maxbound ax r seq]. *)
+
+  val script : rule_t -> rule_t -> Proof.t -> int list
+  (** [script ax r prf] records how the closed proof [prf], found by any of
+      the searches above, is rebuilt from its root sequent using the axioms
+      [ax] and rules [r]: for each node in the order it is closed, the
+      position of the rule application producing it.  As a script is just a
+      list of integers it can be passed between processes, which proofs
+      cannot as terms are hash-consed.  Raises [Not_found] if [prf] is not
+      produced by [ax] and [r]. *)
+
+  val rebuild : rule_t -> rule_t -> Seq.t -> int list -> Proof.t
+  (** [rebuild ax r seq script] replays [script] from [seq]. *)
+
+  val lookup :
+    rule_t -> rule_t -> int -> string -> Seq.t -> Proof.t option option
+  (** [lookup ax r maxbound key seq] consults the [Lemmadb] entry under [key]
+      for the outcome of searching for a proof of [seq] up to [maxbound]:
+      [Some (Some prf)] if a recorded script rebuilds a closed, sound proof
+      [prf], [Some None] if a search up to at least [maxbound] failed, and
+      [None] if the search has to be carried out. *)
+
+  val remember : rule_t -> rule_t -> int -> string -> Proof.t option -> unit
+  (** [remember ax r maxbound key res] records in [Lemmadb] the outcome [res]
+      of a complete search up to [maxbound].  Failures are not recorded when
+      [!transpositions] or [!nogoods] is set, as the search is then
+      incomplete. *)
+
   val print_proof_stats : Proof.t -> unit
 end
 
@@ -33,12 +120,312 @@ module Make (Seq : Sequent.S) = struct
   (* remember last successful search depth *)
   let last_search_depth = ref 0
 
-  let rec idfs bound maxbound ax r seq =
-    if Int.( > ) bound maxbound then None
+  let transpositions = ref false
+
+  let nogoods = ref false
+
+  (* with [!nogoods] the table tells sequents apart only up to tags *)
+  module SeqHash = Hashtbl.Make (struct
+    type t = Seq.t
+
+    let equal s s' =
+      if !nogoods then Seq.equal_upto_tags s s' else Seq.equal s s'
+
+    let hash = Seq.hash_upto_tags
+  end)
+
+  (* [failed] is the largest remaining depth at which the sequent could not *)
+  (* be closed, [closed] a self-contained proof of it along with the *)
+  (* remaining depth at which it was found and the sequent itself, as the *)
+  (* one it is looked up for may only match it up to tags *)
+  type tt_entry = {failed: int; closed: (int * Seq.t * Proof.t) option}
+
+  let no_entry = {failed= -1; closed= None}
+
+  let tt_record table bound idx seq res =
+    let entry = Option.dest no_entry Fun.id (SeqHash.find_opt table seq) in
+    let entry =
+      match res with
+      | None -> {entry with failed= Int.max entry.failed bound}
+      | Some _ when not !transpositions -> entry
+      | Some prf -> (
+        match entry.closed with
+        | Some (d, _, _) when Int.( <= ) d bound -> entry
+        | _ ->
+            let subprf = Proof.extract_subproof idx prf in
+            if Proof.is_closed subprf && Proof.check subprf then
+              {entry with closed= Some (bound, seq, subprf)}
+            else entry )
+    in
+    SeqHash.replace table seq entry
+
+  let jobs = ref 1
+
+  (* As [dfs] below, but also returns the choices made, most recent first, *)
+  (* so that the proof can be rebuilt by [replay] in another process; *)
+  (* [-1] stands for an axiom, [i] for the [i]th rule application *)
+  let rec traced_dfs ax r bound idx (path, prf) =
+    if Int.( < ) bound 0 then None
     else
-      let rec dfs bound idx prf =
-        if Int.( < ) bound 0 then None
-        else
+      match L.find_opt (fun (ss', _) -> Blist.is_empty ss') (ax idx prf) with
+      | Some (_, prf') -> Some (-1 :: path, prf')
+      | None ->
+          L.find_map
+            (fun (i, (subgoals', prf')) ->
+              Blist.fold_left
+                (fun res idx' ->
+                  Option.bind (traced_dfs ax r (bound - 1) idx') res )
+                (Some (i :: path, prf'))
+                subgoals' )
+            (Blist.mapi (fun i app -> (i, app)) (r idx prf))
+
+  let rec replay ax r idx (path, prf) =
+    match path with
+    | [] -> invalid_arg "Prover.replay"
+    | i :: path when Int.( < ) i 0 ->
+        (path, snd (L.find (fun (ss', _) -> Blist.is_empty ss') (ax idx prf)))
+    | i :: path ->
+        let subgoals', prf' = L.nth (r idx prf) i in
+        Blist.fold_left
+          (fun acc idx' -> replay ax r idx' acc)
+          (path, prf') subgoals'
+
+  let rebuild ax r seq path = snd (replay ax r 0 (path, Proof.mk seq))
+
+  let lookup ax r maxbound key seq =
+    (* a script may not replay, e.g. if the rules have changed since *)
+    let reuse (path, depth) =
+      match rebuild ax r seq path with
+      | prf when Proof.is_closed prf && Proof.check prf ->
+          last_search_depth := depth ;
+          Some (Some prf)
+      | _ -> None
+      | exception (Not_found | Invalid_argument _ | Failure _) -> None
+    in
+    let res =
+      Option.bind
+        (fun entry ->
+          match Option.bind reuse entry.Lemmadb.script with
+          | None when Int.( >= ) entry.Lemmadb.failed maxbound -> Some None
+          | res -> res )
+        (Lemmadb.find key)
+    in
+    if Option.is_some res then Stats.Lemmas.hit () else Stats.Lemmas.miss () ;
+    res
+
+  let premises n =
+    if Node.is_inf n then
+      let _, _, ps, _ = Node.dest_inf n in
+      ps
+    else []
+
+  (* [n] in [prf] was produced by the same inference as [tn] in [target], *)
+  (* given the correspondence [nodes] between their indices so far *)
+  let agrees target nodes tn prf n =
+    let _, descr = Node.dest tn in
+    let _, descr' = Node.dest n in
+    String.equal descr descr'
+    &&
+    if Node.is_axiom tn then Node.is_axiom n
+    else if Node.is_backlink tn then
+      Node.is_backlink n
+      &&
+      let _, _, t, _ = Node.dest_backlink tn in
+      let _, _, t', _ = Node.dest_backlink n in
+      Option.dest false (Int.equal t') (Int.Map.find_opt t nodes)
+    else
+      Node.is_inf n
+      && Blist.equal
+           (fun p p' ->
+             Seq.equal (Proof.get_seq p target) (Proof.get_seq p' prf) )
+           (premises tn) (premises n)
+
+  let script ax r target =
+    let rec walk (path, nodes, prf) tidx =
+      let idx = Int.Map.find tidx nodes in
+      let tn = Proof.find tidx target in
+      let closing =
+        Option.dest [] (fun (_, prf') -> [(-1, ([], prf'))])
+          (L.find_opt (fun (ss', _) -> Blist.is_empty ss') (ax idx prf))
+      in
+      let i, (subgoals', prf') =
+        L.find
+          (fun (_, (_, prf')) ->
+            agrees target nodes tn prf' (Proof.find idx prf') )
+          (closing @ Blist.mapi (fun i app -> (i, app)) (r idx prf))
+      in
+      let pairs =
+        Blist.combine (premises (Proof.find idx prf')) (premises tn)
+      in
+      let nodes =
+        Blist.fold_left
+          (fun nodes (p, tp) -> Int.Map.add tp p nodes)
+          nodes pairs
+      in
+      Blist.fold_left
+        (fun acc idx' ->
+          walk acc (snd (L.find (fun (p, _) -> Int.equal p idx') pairs)) )
+        (i :: path, nodes, prf')
+        subgoals'
+    in
+    let path, _, _ =
+      walk ([], Int.Map.singleton 0 0, Proof.mk (Proof.get_seq 0 target)) 0
+    in
+    Blist.rev path
+
+  let remember ax r maxbound key = function
+    | Some prf -> (
+      try Lemmadb.record_proof key (script ax r prf) !last_search_depth
+      with Not_found -> () )
+    | None ->
+        if not (!transpositions || !nogoods) then
+          Lemmadb.record_failure key maxbound
+
+  (* a worker receives indices of rule applications at the root and *)
+  (* answers each with the choices closing it, if any *)
+  let par_worker ax r bound apps ic oc =
+    while true do
+      let i : int = Marshal.from_channel ic in
+      let subgoals', prf' = L.nth apps i in
+      let res =
+        Blist.fold_left
+          (fun res idx' -> Option.bind (traced_dfs ax r (bound - 1) idx') res)
+          (Some ([i], prf'))
+          subgoals'
+      in
+      Marshal.to_channel oc (Option.map fst res : int list option) [] ;
+      flush oc
+    done
+
+  let par_search bound ax r seq =
+    let prf = Proof.mk seq in
+    match L.find_opt (fun (ss', _) -> Blist.is_empty ss') (ax 0 prf) with
+    | Some (_, prf') -> Some prf'
+    | None ->
+        let apps = r 0 prf in
+        let napps = Blist.length apps in
+        let workers =
+          Blist.fold_left
+            (fun workers _ ->
+              Worker.spawn ~siblings:workers (par_worker ax r bound apps)
+              :: workers )
+            []
+            (Blist.init (Int.min !jobs napps) Fun.id)
+        in
+        let next = ref 0 in
+        let assign w =
+          if Int.( < ) !next napps then (
+            Worker.send w !next ;
+            incr next ;
+            true )
+          else false
+        in
+        let rec loop busy =
+          if Blist.is_empty busy then None
+          else
+            let done_ = Worker.ready busy in
+            let busy = Blist.filter (fun w -> not (L.memq w done_)) busy in
+            (* a worker that died answers nothing, and is given no more *)
+            let answers =
+              Blist.map
+                (fun w -> (w, (Worker.receive w : int list option option)))
+                done_
+            in
+            match L.find_map (fun (_, res) -> Option.flatten res) answers with
+            | Some path -> Some path
+            | None ->
+                let alive =
+                  Blist.filter_map
+                    (fun (w, res) -> Option.map (fun _ -> w) res)
+                    answers
+                in
+                loop (Blist.filter assign alive @ busy)
+        in
+        let path =
+          try
+            let path = loop (Blist.filter assign workers) in
+            Worker.shutdown workers ; path
+          with e -> Worker.shutdown workers ; raise e
+        in
+        Option.map (fun path -> snd (replay ax r 0 (Blist.rev path, prf))) path
+
+  let checkpoint = ref ""
+
+  (* the depth bound reached and the first alternative at the root not *)
+  (* yet exhausted at it, for each printed sequent being searched for *)
+  type checkpoint_t = {reached: int; root: int}
+
+  let read_checkpoints () : (string, checkpoint_t) Hashtbl.t =
+    match open_in_bin !checkpoint with
+    | exception Sys_error _ -> Hashtbl.create 1
+    | ic ->
+        let cps =
+          try (Marshal.from_channel ic : (string, checkpoint_t) Hashtbl.t)
+          with End_of_file | Failure _ -> Hashtbl.create 1
+        in
+        close_in ic ; cps
+
+  let update_checkpoints seq cp =
+    let cps = read_checkpoints () in
+    ( match cp with
+    | Some cp -> Hashtbl.replace cps (Seq.to_string seq) cp
+    | None -> Hashtbl.remove cps (Seq.to_string seq) ) ;
+    if Int.equal (Hashtbl.length cps) 0 then (
+      if Sys.file_exists !checkpoint then Sys.remove !checkpoint )
+    else
+      let oc = open_out_bin !checkpoint in
+      Marshal.to_channel oc cps [] ;
+      close_out oc
+
+  let idfs bound maxbound ax r seq =
+    let table = SeqHash.create 997 in
+    let resumed =
+      if String.equal !checkpoint "" then None
+      else Hashtbl.find_opt (read_checkpoints ()) (Seq.to_string seq)
+    in
+    (* the alternative at the root being searched, and the number of them *)
+    (* already exhausted at the bound resumed from *)
+    let root = ref 0 in
+    let skip =
+      ref
+        (Option.dest 0
+           (fun cp -> if Int.( >= ) cp.reached bound then cp.root else 0)
+           resumed)
+    in
+    let bound =
+      Option.dest bound (fun cp -> Int.max bound cp.reached) resumed
+    in
+    let rec idfs bound =
+      if Int.( > ) bound maxbound then None
+      else
+        let hit () =
+          if !transpositions then Stats.Transpositions.hit () ;
+          if !nogoods then Stats.Nogoods.hit ()
+        in
+        let miss () =
+          if !transpositions then Stats.Transpositions.miss () ;
+          if !nogoods then Stats.Nogoods.miss ()
+        in
+        let rec dfs bound idx prf =
+          if Int.( < ) bound 0 then None
+          else if not (!transpositions || !nogoods) then search bound idx prf
+          else
+            let seq = Proof.get_seq idx prf in
+            let entry =
+              Option.dest no_entry Fun.id (SeqHash.find_opt table seq)
+            in
+            match entry.closed with
+            | Some (d, seq', subprf)
+              when Int.( <= ) d bound && Seq.equal seq seq' ->
+                hit () ;
+                Some (Proof.add_subprf subprf idx prf)
+            | _ when Int.( <= ) bound entry.failed -> hit () ; None
+            | _ ->
+                miss () ;
+                let res = search bound idx prf in
+                tt_record table bound idx seq res ;
+                res
+        and search bound idx prf =
           let () =
             debug (fun () ->
                 "Trying to close node: " ^ string_of_int idx ^ "\n"
@@ -50,18 +437,142 @@ module Make (Seq : Sequent.S) = struct
           in
           if Option.is_some res then res
           else
+            let at_root = Int.equal idx 0 in
             L.find_map
-              (fun (subgoals', prf') ->
+              (fun (i, (subgoals', prf')) ->
+                if at_root then root := i ;
                 Blist.fold_left
                   (fun optprf idx' -> Option.bind (dfs (bound - 1) idx') optprf)
                   (Some prf') subgoals' )
-              (r idx prf)
-      in
-      match dfs bound 0 (Proof.mk seq) with
-      | None -> idfs (bound + 1) maxbound ax r seq
-      | res ->
-          last_search_depth := bound ;
-          res
+              (Blist.filter
+                 (fun (i, _) -> (not at_root) || Int.( >= ) i !skip)
+                 (Blist.mapi (fun i app -> (i, app)) (r idx prf)))
+        in
+        root := !skip ;
+        let res =
+          try
+            if Int.( > ) !jobs 1 then par_search bound ax r seq
+            else dfs bound 0 (Proof.mk seq)
+          with Timeout when not (String.equal !checkpoint "") ->
+            update_checkpoints seq
+              (Some
+                 { reached= bound
+                 ; root= (if Int.( > ) !jobs 1 then 0 else !root) }) ;
+            raise Timeout
+        in
+        skip := 0 ;
+        match res with
+        | None -> idfs (bound + 1)
+        | res ->
+            last_search_depth := bound ;
+            res
+    in
+    let res = idfs bound in
+    if Option.is_some resumed then update_checkpoints seq None ;
+    res
+
+  type heuristic_t = Proof.t -> int list -> int
+
+  let sum_over_goals f prf goals =
+    Blist.fold_left (fun n idx -> n + f (Proof.get_seq idx prf)) 0 goals
+
+  let has_backlink_candidate prf idx =
+    let seq = Proof.get_seq idx prf in
+    Blist.exists
+      (fun (idx', n) ->
+        (not (Int.equal idx idx')) && Seq.equal_upto_tags seq (Node.get_seq n) )
+      (Proof.get_ancestry idx prf)
+
+  let heuristics =
+    [ ("goals", fun _ goals -> Blist.length goals)
+    ; ("size", sum_over_goals Seq.size)
+    ; ("preds", sum_over_goals (fun seq -> Tags.cardinal (Seq.tags seq)))
+    ; ( "backlinks"
+      , fun prf goals ->
+          Blist.length
+            (Blist.filter
+               (fun idx -> not (has_backlink_candidate prf idx))
+               goals) ) ]
+
+  (* a partial proof along with its open goals and their depths, in the *)
+  (* order in which they are to be closed *)
+  type bf_state = {prf: Proof.t; goals: (int * int) list; depth: int}
+
+  exception Frontier_full
+
+  (* Search over partial proofs held in a priority queue, always expanding *)
+  (* the first open goal of the lowest-scoring state.  Raises *)
+  (* [Frontier_full] if more than [cap] states are ever queued. *)
+  let queue_search cap score maxbound ax r seq =
+    (* states of equal score are kept in a stack, so ties are broken *)
+    (* depth-first *)
+    let push (q, n) st =
+      if Int.( >= ) n cap then raise Frontier_full ;
+      Stats.Frontier.record (n + 1) ;
+      ( Int.Map.update (score st)
+          (fun sts -> Some (st :: Option.dest [] Fun.id sts))
+          q
+      , n + 1 )
+    in
+    let rec search (q, n) =
+      if Int.Map.is_empty q then None
+      else
+        let key, sts = Int.Map.min_binding q in
+        let st, sts = Blist.decons sts in
+        let q =
+          if Blist.is_empty sts then Int.Map.remove key q
+          else Int.Map.add key sts q
+        in
+        let n = n - 1 in
+        match st.goals with
+        | [] ->
+            last_search_depth := st.depth ;
+            Some st.prf
+        | (_, d) :: _ when Int.( > ) d maxbound -> search (q, n)
+        | (idx, d) :: goals -> (
+            let () =
+              debug (fun () ->
+                  "Trying to close node: " ^ string_of_int idx ^ "\n"
+                  ^ Proof.to_string st.prf ^ "\n" )
+            in
+            Stats.Frontier.expand () ;
+            match
+              L.find_opt (fun (ss', _) -> Blist.is_empty ss') (ax idx st.prf)
+            with
+            | Some (_, prf') -> search (push (q, n) {st with prf= prf'; goals})
+            | None ->
+                let depth = Int.max st.depth (d + 1) in
+                search
+                  (Blist.fold_left
+                     (fun qn (subgoals', prf') ->
+                       let goals' =
+                         Blist.map (fun idx' -> (idx', d + 1)) subgoals'
+                       in
+                       push qn {prf= prf'; goals= goals' @ goals; depth} )
+                     (q, n) (r idx st.prf)) )
+    in
+    search
+      (push (Int.Map.empty, 0) {prf= Proof.mk seq; goals= [(0, 0)]; depth= 0})
+
+  let best_first maxbound h ax r seq =
+    queue_search max_int
+      (fun st -> h st.prf (Blist.map fst st.goals))
+      maxbound ax r seq
+
+  let bfs_frontier_cap = ref 100000
+
+  let bfs minbound maxbound ax r seq =
+    (* expanding shallowest goals first makes for breadth-first search *)
+    let depth_of_goal st =
+      match st.goals with [] -> -1 | (_, d) :: _ -> d
+    in
+    try queue_search !bfs_frontier_cap depth_of_goal maxbound ax r seq
+    with Frontier_full ->
+      debug (fun () ->
+          "Frontier exceeded " ^ string_of_int !bfs_frontier_cap
+          ^ " states, falling back to IDFS" ) ;
+      Stats.Frontier.overflow () ;
+      idfs minbound maxbound ax r seq
 
   let print_proof_stats proof =
     let size = Proof.size proof in
@@ -71,112 +582,4 @@ module Make (Seq : Sequent.S) = struct
       ^ string_of_int links ^ " back-links." ) ;
     print_endline
       ("Required search depth was " ^ string_of_int !last_search_depth)
-
-  (* type app_state =                                                                              *)
-  (*   {                                                                                           *)
-  (*     prf : Proof.t;                                                                            *)
-  (*     depth : int;                                                                              *)
-  (*     goals : (int * int) list;                                                                 *)
-  (*   }                                                                                           *)
-  (* let mk_app p d g = { prf=p; depth=d; goals=g }                                                *)
-  
-  (* type proof_state =                                                                            *)
-  (*   {                                                                                           *)
-  (*     seq_no : int ;                                                                            *)
-  (*     par : int ;                                                                               *)
-  (*     idx : int;                                                                                *)
-  (*     apps : app_state L.t                                                                      *)
-  (*   }                                                                                           *)
-  
-  (* let state_seq_no = ref 0                                                                      *)
-  
-  (* let mk_state par idx apps =                                                                   *)
-  (*   {                                                                                           *)
-  (*     seq_no = (incr state_seq_no; !state_seq_no);                                              *)
-  (*     par=par; idx=idx; apps=apps                                                               *)
-  (*   }                                                                                           *)
-  
-  (* let pop_parents sn stack =                                                                    *)
-  (*   let rec loop aux s = function                                                               *)
-  (*     | [] -> Blist.rev aux                                                                     *)
-  (*     | p::ps ->                                                                                *)
-  (*         if p.seq_no = s then                                                                  *)
-  (*           loop aux p.par ps                                                                   *)
-  (*         else                                                                                  *)
-  (*           loop (p::aux) s ps in                                                               *)
-  (*   loop [] sn stack                                                                            *)
-  
-  (* let expand_proof_state par_seq_no app rule =                                                  *)
-  (*   let () = assert (not (Proof.is_closed app.prf) && app.goals<>[]) in                         *)
-  (*   (* idx is the goal being closed and goal_depth is its depth *)                              *)
-  (*   let ((idx,goal_depth), goals) = Blist.decons app.goals in                                   *)
-  (*   (* let () = assert (Node.is_open (Proof.find idx app.prf) && app.depth >= goal_depth) in *) *)
-  (*   let new_goal_depth = goal_depth+1 in                                                        *)
-  (*   let new_prf_depth = max app.depth new_goal_depth in                                         *)
-  (*   let newapps =                                                                               *)
-  (*     L.map                                                                                     *)
-  (*       begin fun (g',p') ->                                                                    *)
-  (*         mk_app                                                                                *)
-  (*           p'                                                                                  *)
-  (*           new_prf_depth                                                                       *)
-  (*           (Blist.rev_append (Blist.rev_map (fun j -> (j,new_goal_depth)) g') goals)           *)
-  (*       end                                                                                     *)
-  (*       (rule idx app.prf) in                                                                   *)
-  (*   mk_state                                                                                    *)
-  (*     par_seq_no                                                                                *)
-  (*     idx                                                                                       *)
-  (*     newapps                                                                                   *)
-  
-  (* let bfs maxbound ax rl seq =                                                                  *)
-  (*   let rule =  Rule.first [ ax ; Rule.compose rl (Rule.attempt ax) ] in                        *)
-  (*   let rec aux bound frontier stack =                                                          *)
-  (*     if bound > maxbound || (stack = [] && frontier = []) then None else                       *)
-  (*     if stack=[] then                                                                          *)
-  (*       (* finished current depth, increase and repeat *)                                       *)
-  (*       aux (bound + 1) [] (Blist.rev frontier)                                                 *)
-  (*     else                                                                                      *)
-  (*     let (proof_state, stack) = Blist.decons stack in                                          *)
-  (*     (* if no applications left, go to next set of applications *)                             *)
-  (*     if L.is_empty proof_state.apps then aux bound frontier stack else                         *)
-  (*     (* next rule application *)                                                               *)
-  (*     let (app, apps) = Blist.decons proof_state.apps in                                        *)
-  (*     let () = assert (app.depth <= bound) in                                                   *)
-  (*     let () = assert (Blist.for_all (fun (_,gd) -> gd <= bound) app.goals) in                  *)
-  (*     (* push remaining applications *)                                                         *)
-  (*     let stack = {proof_state with apps=apps} :: stack in                                      *)
-  (*     if app.goals=[] then                                                                      *)
-  (*       begin                                                                                   *)
-  (*         (* no subgoals left, so it must be a closed proof *)                                  *)
-  (*         assert (Proof.is_closed app.prf) ;                                                    *)
-  (*         Some (app.prf,app.depth)                                                              *)
-  (*       end else                                                                                *)
-  (*     let () = assert (not (Proof.is_closed app.prf)) in                                        *)
-  (*     let () = debug (fun () ->                                                                 *)
-  (*       "Trying to close node: " ^ (string_of_int (fst (Blist.hd app.goals))) ^ "\n" ^          *)
-  (*       (Proof.to_string app.prf) ^ "\n"                                                        *)
-  (*       ) in                                                                                    *)
-  (*     if Blist.exists (fun (_,gd) -> gd = bound) app.goals then                                 *)
-  (*       begin                                                                                   *)
-  (*         (* if any of the open goals is at the current depth *)                                *)
-  (*         (* then keep for later *)                                                             *)
-  (*         let frontier = (expand_proof_state proof_state.seq_no app rule) :: frontier in        *)
-  (*         aux bound frontier stack                                                              *)
-  (*       end else                                                                                *)
-  (*     let stack = if Proof.is_closed_at app.prf proof_state.idx  then                           *)
-  (*       (* last application resulted in no new open subgoals *)                                 *)
-  (*       (* thus we will pop all generators of applications *)                                   *)
-  (*       (* that are parents of the current one *)                                               *)
-  (*       (* this is equivalent to a prolog cut over the other possible *)                        *)
-  (*       (* closed proofs of these goals *)                                                      *)
-  (*       pop_parents proof_state.seq_no stack                                                    *)
-  (*     else                                                                                      *)
-  (*       stack in                                                                                *)
-  (*     let stack = (expand_proof_state proof_state.seq_no app rule) :: stack in                  *)
-  (*     aux bound frontier stack in                                                               *)
-  (*   let start = Proof.mk seq in                                                                 *)
-  (*   let stack =                                                                                 *)
-  (*     [expand_proof_state 0 (mk_app start 0 [(0,0)]) rule] in                                   *)
-  (*   Option.map                                                                                  *)
-  (*     (fun (p, d) -> last_search_depth := d ; p)                                                *)
-  (*     (aux 1 [] stack)                                                                          *)
 end
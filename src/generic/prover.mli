@@ -9,9 +9,91 @@ module type S = sig
 
   val last_search_depth : int ref
 
+  val transpositions : bool ref
+  (** Whether [idfs] keeps a transposition table across depth iterations.
+      A sequent that failed to close with some remaining depth is not
+      searched again with at most that depth, and a sound, closed subproof
+      of a sequent is reused instead of being searched for anew.  As back-links
+      make the outcome of a search depend on the ancestors of a node, the
+      former may cause proofs to be missed. *)
+
+  val nogoods : bool ref
+  (** Whether [idfs] remembers, up to tags, the sequents that could not be
+      closed with some remaining depth, and fails at once on meeting them
+      again with at most that depth, e.g. in another branch of the search.
+      As with [transpositions], back-links may make this miss proofs. *)
+
+  val jobs : int ref
+  (** Number of worker processes [idfs] farms the alternative rule
+      applications at the root out to; [1] searches sequentially.  The first
+      worker to close its branch wins and the rest are killed, so the proof
+      found need not be the one a sequential search finds first. *)
+
+  val checkpoint : string ref
+  (** A file [idfs] saves its progress to when interrupted by [Timeout], and
+      resumes from when searching for the same sequent again; the empty
+      string disables this.  The progress is the depth bound reached and,
+      unless the root is searched in parallel, the first alternative rule
+      application at the root not yet exhausted at that bound.  It is kept
+      per sequent, and dropped once the search for it completes.  Caches
+      such as the transposition table hold hash-consed sequents and are not
+      saved. *)
+
   val idfs : int -> int -> rule_t -> rule_t -> Seq.t -> Proof.t option
 
-  (* val bfs : int -> rule_t -> rule_t -> Seq.t -> Proof.t option   *)
+  type heuristic_t = Proof.t -> int list -> int
+  (** A heuristic scores a partial proof and its open goals; lower scores are
+      expanded first. *)
+
+  val heuristics : (string * heuristic_t) list
+  (** The available heuristics, by name:
+      - ["goals"] counts the open goals;
+      - ["size"] sums the [Seq.size] of the open sequents;
+      - ["preds"] sums the numbers of tags, i.e. of inductive predicates, in
+        the open sequents;
+      - ["backlinks"] counts the open goals without an ancestor equal up to
+        tags, i.e. an obvious back-link candidate. *)
+
+  val best_first :
+    int -> heuristic_t -> rule_t -> rule_t -> Seq.t -> Proof.t option
+  (** [best_first maxbound h ax r seq] searches for a proof of [seq] by
+      always expanding the first open goal of the partial proof with the
+      lowest score under [h].  Goals deeper than [maxbound] are abandoned. *)
+
+  val bfs_frontier_cap : int ref
+  (** Maximum number of partial proofs [bfs] keeps queued. *)
+
+  val bfs : int -> int -> rule_t -> rule_t -> Seq.t -> Proof.t option
+  (** [bfs minbound maxbound ax r seq] searches breadth-first, expanding the
+      partial proofs whose next open goal is shallowest first.  Should the
+      frontier outgrow [!bfs_frontier_cap] it falls back to
+      [idfs minbound maxbound ax r seq]. *)
+
+  val script : rule_t -> rule_t -> Proof.t -> int list
+  (** [script ax r prf] records how the closed proof [prf], found by any of
+      the searches above, is rebuilt from its root sequent using the axioms
+      [ax] and rules [r]: for each node in the order it is closed, the
+      position of the rule application producing it.  As a script is just a
+      list of integers it can be passed between processes, which proofs
+      cannot as terms are hash-consed.  Raises [Not_found] if [prf] is not
+      produced by [ax] and [r]. *)
+
+  val rebuild : rule_t -> rule_t -> Seq.t -> int list -> Proof.t
+  (** [rebuild ax r seq script] replays [script] from [seq]. *)
+
+  val lookup :
+    rule_t -> rule_t -> int -> string -> Seq.t -> Proof.t option option
+  (** [lookup ax r maxbound key seq] consults the [Lemmadb] entry under [key]
+      for the outcome of searching for a proof of [seq] up to [maxbound]:
+      [Some (Some prf)] if a recorded script rebuilds a closed, sound proof
+      [prf], [Some None] if a search up to at least [maxbound] failed, and
+      [None] if the search has to be carried out. *)
+
+  val remember : rule_t -> rule_t -> int -> string -> Proof.t option -> unit
+  (** [remember ax r maxbound key res] records in [Lemmadb] the outcome [res]
+      of a complete search up to [maxbound].  Failures are not recorded when
+      [!transpositions] is set. *)
+
   val print_proof_stats : Proof.t -> unit
 end
 
@@ -12,9 +12,17 @@ module type S = sig
   (** As [equal] but ignoring tags.  Used to check that the target of a
       backlink [NODE] is equal to that marking it, ignoring tags.*)
 
+  val hash_upto_tags : t -> int
+  (** A hash function ignoring tags, so that [equal_upto_tags s s'] (and
+      hence [equal s s']) implies [hash_upto_tags s = hash_upto_tags s']. *)
+
   val tags : t -> Tags.t
   (** Returns set of tags in sequent. *)
 
+  val size : t -> int
+  (** A structural measure of the sequent, e.g. its number of atoms and
+      predicates.  Used by the prover's "size" heuristic. *)
+
   val to_string : t -> string
 
   val pp : Format.formatter -> t -> unit
@@ -21,18 +21,77 @@ external check_soundness : unit -> bool = "check_soundness"
 
 external set_initial_vertex : int -> unit = "set_initial_vertex"
 
-module IntPairSet = Treeset.Make (Pair.Make (Int) (Int))
-
-(* computes the composition of two sets of pairs *)
-let compose t1 t2 =
-  IntPairSet.fold
-    (fun (x, y) a ->
-      IntPairSet.fold
-        (fun (w, z) b -> if Int.equal y w then IntPairSet.add (x, z) b else b)
-        t2 a )
-    t1 IntPairSet.empty
+(* A relation over tags, indexed by source tag: each source is mapped to the
+   (non-empty) set of its targets.  Composition then costs one lookup per
+   intermediate tag instead of a scan of the whole right-hand relation. *)
+module TagRel = struct
+  type t = Int.Set.t Int.Map.t
+
+  let empty = Int.Map.empty
+
+  let is_empty = Int.Map.is_empty
+
+  let add (x, y) r =
+    Int.Map.update x
+      (function
+        | None -> Some (Int.Set.singleton y) | Some ys -> Some (Int.Set.add y ys))
+      r
+
+  let of_list l = Blist.fold_left (fun r p -> add p r) empty l
+
+  let iter f r =
+    Int.Map.iter (fun x ys -> Int.Set.iter (fun y -> f (x, y)) ys) r
+
+  let union r r' =
+    Int.Map.merge
+      (fun _ ys ys' ->
+        match (ys, ys') with
+        | Some ys, Some ys' -> Some (Int.Set.union ys ys')
+        | None, ys | ys, None -> ys )
+      r r'
+
+  let subset r r' =
+    Int.Map.for_all
+      (fun x ys ->
+        match Int.Map.find_opt x r' with
+        | None -> false
+        | Some ys' -> Int.Set.subset ys ys' )
+      r
+
+  (* computes the composition of two relations *)
+  let compose r r' =
+    if is_empty r' then empty
+    else
+      Int.Map.fold
+        (fun x ys acc ->
+          let zs =
+            Int.Set.fold
+              (fun y zs ->
+                match Int.Map.find_opt y r' with
+                | None -> zs
+                | Some zs' -> Int.Set.union zs' zs )
+              ys Int.Set.empty
+          in
+          if Int.Set.is_empty zs then acc else Int.Map.add x zs acc )
+        r empty
+
+  let domain r = Int.Map.fold (fun x _ s -> Int.Set.add x s) r Int.Set.empty
+
+  let range r = Int.Map.fold (fun _ ys s -> Int.Set.union ys s) r Int.Set.empty
+
+  let pp fmt r =
+    let pairs =
+      Int.Map.fold
+        (fun x ys acc -> Int.Set.fold (fun y acc -> (x, y) :: acc) ys acc)
+        r []
+    in
+    Format.fprintf fmt "@[{%a}@]"
+      (Blist.pp pp_commasp (fun fmt (x, y) ->
+           Format.fprintf fmt "@[(%i,@ %i)@]" x y ))
+      (Blist.rev pairs)
+end
 
-type abstract_node = Int.Set.t * (int * IntPairSet.t * IntPairSet.t) list
+type abstract_node = Int.Set.t * (int * TagRel.t * TagRel.t) list
 
 type t = abstract_node Int.Map.t
 
@@ -55,7 +114,7 @@ let mk_abs_node tags succs tps_pair =
       (fun i (tps, tps') ->
         let tps, tps' =
           Pair.map
-            (Tagpairs.map_to IntPairSet.add IntPairSet.empty
+            (Tagpairs.map_to TagRel.add TagRel.empty
                (Pair.map Tags.Elt.to_int))
             (tps, tps')
         in
@@ -64,19 +123,20 @@ let mk_abs_node tags succs tps_pair =
   in
   (tags, subg)
 
+let build_node tags premises =
+  let premises =
+    List.map
+      (fun (target, allpairs, progpairs) ->
+        (target, TagRel.of_list allpairs, TagRel.of_list progpairs) )
+      premises
+  in
+  (tags, premises)
+
 let build_proof nodes =
   Int.Map.of_list
     (List.map
        (fun (id, tags, premises) ->
-         let premises =
-           List.map
-             (fun (target, allpairs, progpairs) ->
-               ( target
-               , IntPairSet.of_list allpairs
-               , IntPairSet.of_list progpairs ) )
-             premises
-         in
-         (id, (Int.Set.of_list tags, premises)) )
+         (id, build_node (Int.Set.of_list tags) premises) )
        nodes)
 
 (* has one child and is not a self loop *)
@@ -85,17 +145,6 @@ let is_single_node idx n =
   | [(idx', _, _)] -> not (Int.equal idx' idx)
   | _ -> false
 
-let fathers_grandchild prf idx n =
-  match get_subg n with
-  | [(grandchild, _, _)] ->
-      if Int.equal idx grandchild then invalid_arg "fathers_grandchild1"
-      else
-        Int.Map.exists
-          (fun idx' par_node ->
-            in_children idx par_node && in_children grandchild par_node )
-          prf
-  | _ -> invalid_arg "fathers_grandchild2"
-
 let pp_proof_node fmt n =
   let aux fmt (tags, subg) =
     Format.fprintf fmt "tags=%a " Int.Set.pp tags ;
@@ -104,7 +153,7 @@ let pp_proof_node fmt n =
       Blist.pp pp_semicolonsp
         (fun fmt (i, tv, tp) ->
           Format.fprintf fmt "(goal=%a, valid=%a, prog=%a)" Format.pp_print_int
-            i IntPairSet.pp tv IntPairSet.pp tp )
+            i TagRel.pp tv TagRel.pp tp )
         fmt subg
   in
   Format.fprintf fmt "@[%a@]" aux n
@@ -116,72 +165,110 @@ let pp fmt prf =
     prf ;
   Format.close_box ()
 
-let remove_dead_nodes prf' =
-  let prf = ref prf' in
-  let process_node child par_idx n =
-    if not (in_children child n) then ()
-    else
-      let newparent =
-        let tags, subg = n in
-        match subg with
-        | [_] -> (tags, [])
-        | _ -> (tags, Blist.remove_nth (index_of_child child n) subg)
-      in
-      prf := Int.Map.add par_idx newparent !prf
-  in
-  let remove_dead_node idx n =
-    let () = prf := Int.Map.remove idx !prf in
-    Int.Map.iter (fun p n -> process_node idx p n) !prf
-  in
-  let cont = ref true in
-  while !cont do
-    match
-      Int.Map.find_map (fun idx n -> (not (Int.equal idx 0)) && is_leaf n) !prf
-    with
-    | Some (idx, n) -> remove_dead_node idx n
-    | None -> cont := false
-  done ;
-  !prf
-
-let fuse_single_nodes prf' init =
-  let prf = ref prf' in
-  let process_node child grand_child tv tp par_idx n =
-    if not (in_children child n) then ()
+(* maps every node to the set of nodes that have it as a premise *)
+let parents_of prf =
+  Int.Map.fold
+    (fun idx n ps ->
+      Blist.fold_left
+        (fun ps (child, _, _) ->
+          Int.Map.update child
+            (function
+              | None -> Some (Int.Set.singleton idx)
+              | Some s -> Some (Int.Set.add idx s) )
+            ps )
+        ps (get_subg n) )
+    prf Int.Map.empty
+
+let get_parents idx parents =
+  Option.dest Int.Set.empty Fun.id (Int.Map.find_opt idx parents)
+
+let all_idxs prf =
+  Int.Map.fold (fun idx _ s -> Int.Set.add idx s) prf Int.Set.empty
+
+(* Both simplifications below are driven by a worklist of node indices, so
+   that removing or fusing a node only revisits its neighbours rather than
+   rescanning the whole proof. *)
+let remove_dead_nodes prf =
+  let parents = parents_of prf in
+  let rec aux prf work =
+    if Int.Set.is_empty work then prf
     else
-      let par_tags, par_subg = n in
-      let pos = index_of_child child n in
-      let _, par_tv, par_tp = List.nth par_subg pos in
-      let newsubg =
-        Blist.replace_nth
-          ( grand_child
-          , compose par_tv tv
-          , IntPairSet.union_of_list
-              [compose par_tp tp; compose par_tv tp; compose par_tp tv] )
-          pos par_subg
-      in
-      prf := Int.Map.add par_idx (par_tags, newsubg) !prf
+      let idx = Int.Set.min_elt work in
+      let work = Int.Set.remove idx work in
+      match Int.Map.find_opt idx prf with
+      | Some n when (not (Int.equal idx 0)) && is_leaf n ->
+          let pars = get_parents idx parents in
+          let remove_child par_idx prf =
+            match Int.Map.find_opt par_idx prf with
+            | None -> prf
+            | Some (tags, subg) ->
+                let subg =
+                  Blist.filter (fun (i, _, _) -> not (Int.equal i idx)) subg
+                in
+                Int.Map.add par_idx (tags, subg) prf
+          in
+          aux (Int.Set.fold remove_child pars (Int.Map.remove idx prf))
+            (Int.Set.union pars work)
+      | _ -> aux prf work
   in
-  let fuse_node idx = function
-    | tags, [(child, tv, tp)] ->
-        Int.Map.iter (fun p n -> process_node idx child tv tp p n) !prf ;
-        prf := Int.Map.remove idx !prf
-    | _ -> invalid_arg "fuse_node"
+  aux prf (all_idxs prf)
+
+let fuse_single_nodes prf init =
+  let fuse_edge child grand_child tv tp (par_tags, par_subg) =
+    let pos = index_of_child child (par_tags, par_subg) in
+    let _, par_tv, par_tp = List.nth par_subg pos in
+    (* since [tp] is contained in [tv] and [par_tp] in [par_tv], the
+       composition [par_tp] with [tp] is subsumed by the other two *)
+    let newsubg =
+      Blist.replace_nth
+        ( grand_child
+        , TagRel.compose par_tv tv
+        , TagRel.union (TagRel.compose par_tv tp) (TagRel.compose par_tp tv) )
+        pos par_subg
+    in
+    (par_tags, newsubg)
   in
-  let cont = ref true in
   (* if a parent points to the child of the node to be fused then *)
   (* we would run into difficulties when updating that parent to point *)
   (* directly to the grandchild, so we avoid that altogether *)
-  let p idx n =
+  let fusable prf parents idx n =
     (not (Int.equal idx init))
     && is_single_node idx n
-    && not (fathers_grandchild !prf idx n)
+    &&
+    match get_subg n with
+    | [(grand_child, _, _)] ->
+        not
+          (Int.Set.exists
+             (fun p -> in_children grand_child (Int.Map.find p prf))
+             (get_parents idx parents))
+    | _ -> false
+  in
+  let rec aux prf parents work =
+    if Int.Set.is_empty work then prf
+    else
+      let idx = Int.Set.min_elt work in
+      let work = Int.Set.remove idx work in
+      match Int.Map.find_opt idx prf with
+      | Some ((_, [(child, tv, tp)]) as n) when fusable prf parents idx n ->
+          let pars = get_parents idx parents in
+          let prf =
+            Int.Set.fold
+              (fun p prf ->
+                Int.Map.add p
+                  (fuse_edge idx child tv tp (Int.Map.find p prf))
+                  prf )
+              pars (Int.Map.remove idx prf)
+          in
+          let parents =
+            Int.Map.add child
+              (Int.Set.union pars
+                 (Int.Set.remove idx (get_parents child parents)))
+              (Int.Map.remove idx parents)
+          in
+          aux prf parents (Int.Set.add child (Int.Set.union pars work))
+      | _ -> aux prf parents work
   in
-  while !cont do
-    match Int.Map.find_map p !prf with
-    | Some (idx, n) -> fuse_node idx n
-    | None -> cont := false
-  done ;
-  !prf
+  aux prf (parents_of prf) (all_idxs prf)
 
 let minimize_abs_proof prf init = fuse_single_nodes (remove_dead_nodes prf) init
 
@@ -194,8 +281,8 @@ let check_proof ?(init=0) p =
   in
   let create_trace_pairs i (_, l) =
     let do_tag_transitions (j, tvs, tps) =
-      IntPairSet.iter (fun (k, m) -> set_trace_pair i j k m) tvs ;
-      IntPairSet.iter (fun (k, m) -> set_progress_pair i j k m) tps
+      TagRel.iter (fun (k, m) -> set_trace_pair i j k m) tvs ;
+      TagRel.iter (fun (k, m) -> set_progress_pair i j k m) tps
     in
     Blist.iter do_tag_transitions l
   in
@@ -217,48 +304,36 @@ let check_proof ?(init=0) p =
       "Checking soundness ends, result=" ^ if retval then "OK" else "NOT OK" ) ;
   retval
 
-let valid prf init =
-  let projectl = IntPairSet.map_to Int.Set.add Int.Set.empty Pair.left in
-  let projectr = IntPairSet.map_to Int.Set.add Int.Set.empty Pair.right in
+(* Raise [Invalid_argument], saying why, unless [prf] is a well-formed proof *)
+(* graph containing [init] *)
+let validate prf init =
+  let projectl = TagRel.domain in
+  let projectr = TagRel.range in
   (* init is a node in the proof *)
   if (not (Int.Map.mem init prf)) then
-    let () =
-      prerr_endline
-        (Printf.sprintf "Initial node %i not in proof" init) in
-    false
-  else
+    invalid_arg (Printf.sprintf "Initial node %i not in proof" init) ;
   (* For all nodes n in the proof *)
-  Int.Map.for_all
+  Int.Map.iter
     (fun n_idx n ->
       (* For all premises i of n *)
-      Blist.for_all
+      Blist.iter
         (fun (i, tv, tp) ->
           (* i is a node in the proof *)
           if (not (Int.Map.mem i prf)) then
-            let () =
-              prerr_endline
-                (Printf.sprintf "Goal %i for node %i not in proof" i n_idx) in
-            false
+            invalid_arg
+              (Printf.sprintf "Goal %i for node %i not in proof" i n_idx)
           (* progressing tag pairs of i are a subset of all tagpairs of i *)
-          else if (not (IntPairSet.subset tp tv)) then
-            let () =
-              prerr_endline
-                (Printf.sprintf "Prog pairs for goal %i of node %i not contained in all pairs" i n_idx) in
-            false
+          else if (not (TagRel.subset tp tv)) then
+            invalid_arg
+              (Printf.sprintf "Prog pairs for goal %i of node %i not contained in all pairs" i n_idx)
           (* The left-hand components of all tagpairs are in the tagset of n *)
           else if (not (Int.Set.subset (projectl tv) (get_tags n))) then
-            let () =
-              prerr_endline
-                (Printf.sprintf "Source tags of tagpairs for goal %i of node %i not contained in tags of node" i n_idx) in
-            false
+            invalid_arg
+              (Printf.sprintf "Source tags of tagpairs for goal %i of node %i not contained in tags of node" i n_idx)
           (* The right-hand components of all tagpairs are in the tagset of i *)
           else if (not (Int.Set.subset (projectr tv) (get_tags (Int.Map.find i prf)))) then
-            let () =
-              prerr_endline
-                (Printf.sprintf "Target tags of tagpairs for goal %i of node %i not contained in tags of target" i n_idx) in
-            false
-          else
-            true)
+            invalid_arg
+              (Printf.sprintf "Target tags of tagpairs for goal %i of node %i not contained in tags of target" i n_idx))
         (get_subg n))
     prf
 
@@ -267,47 +342,108 @@ module CheckCache = Hashtbl
 let ccache = CheckCache.create 1000
 (* let limit = ref 1 *)
 
+type cache_status = Hit | Miss | Bypassed
+
+type report =
+  { sound: bool
+  ; size: int * int
+  ; min_size: int * int
+  ; cache: cache_status
+  ; validate_time: float
+  ; minimise_time: float
+  ; check_time: float }
+
+let size prf =
+  ( Int.Map.cardinal prf
+  , Int.Map.fold (fun _ n e -> e + Blist.length (get_subg n)) prf 0 )
+
+(* the soundness of the minimised proof [aprf], from the cache if there *)
+let cached_check init prf aprf =
+  try
+    debug (fun _ -> mk_to_string pp prf) ;
+    debug (fun () -> "Minimized proof:\n" ^ mk_to_string pp aprf) ;
+    Stats.MCCache.call () ;
+    let r = CheckCache.find ccache aprf in
+    Stats.MCCache.end_call () ;
+    Stats.MCCache.hit () ;
+    let () =
+      debug (fun _ ->
+          "Found soundness result in the cache: "
+          ^ if r then "OK" else "NOT OK" )
+    in
+    (r, Hit)
+  with Not_found ->
+    Stats.MCCache.end_call () ;
+    Stats.MCCache.miss () ;
+    let r = check_proof ~init aprf in
+    Stats.MCCache.call () ;
+    CheckCache.add ccache aprf r ;
+    Stats.MCCache.end_call () ;
+    (r, Miss)
+
 let check_proof ?(init=0) prf =
   if (Int.Map.is_empty prf) then
     true
   else
-    let () =
-      if not (valid prf init) then (
-        pp Format.std_formatter prf ;
-        assert false )
-    in
+    let () = validate prf init in
     let aprf = minimize_abs_proof prf init in
     if (Int.Map.is_empty aprf) then
       true
     else
-      let () =
-        if not (valid aprf init) then (
-          pp Format.std_formatter aprf ;
-          assert false )
-      in
-      try
-        debug (fun _ -> mk_to_string pp prf) ;
-        debug (fun () -> "Minimized proof:\n" ^ mk_to_string pp aprf) ;
-        Stats.MCCache.call () ;
-        let r = CheckCache.find ccache aprf in
-        Stats.MCCache.end_call () ;
-        Stats.MCCache.hit () ;
-        let () =
-          debug (fun _ ->
-              "Found soundness result in the cache: "
-              ^ if r then "OK" else "NOT OK" )
-        in
-        r
-      with Not_found ->
-        Stats.MCCache.end_call () ;
-        Stats.MCCache.miss () ;
-        let r = check_proof ~init aprf in
-        Stats.MCCache.call () ;
-        CheckCache.add ccache aprf r ;
-        Stats.MCCache.end_call () ;
-        (* if CheckCache.length ccache > !limit then                                          *)
-        (*   begin                                                                            *)
-        (*     debug (fun () -> "Soundness cache passed limit: " ^ (string_of_int !limit)) ;  *)
-        (*     limit := 10 * !limit                                                           *)
-        (*   end ;                                                                            *)
-        r
+      let () = validate aprf init in
+      fst (cached_check init prf aprf)
+
+(* As [check_proof] with [init] the root 0, the nodes [remove_dead_nodes] *)
+(* keeps besides the root being given as [live]: only those are looked at *)
+let check_live_proof prf live =
+  let keep i = Int.equal i 0 || Int.Set.mem i live in
+  let prune idx =
+    let n = Int.Map.find idx prf in
+    (get_tags n, Blist.filter (fun (i, _, _) -> keep i) (get_subg n))
+  in
+  let pruned =
+    Int.Set.fold
+      (fun idx p -> Int.Map.add idx (prune idx) p)
+      live
+      (Int.Map.singleton 0 (prune 0))
+  in
+  let aprf = fuse_single_nodes pruned 0 in
+  let () = validate aprf 0 in
+  fst (cached_check 0 prf aprf)
+
+(* As [check_proof], timing each phase *)
+let check_proof_report ?(init=0) prf =
+  let start = Unix.gettimeofday () in
+  let report =
+    { sound= true
+    ; size= size prf
+    ; min_size= (0, 0)
+    ; cache= Bypassed
+    ; validate_time= 0.
+    ; minimise_time= 0.
+    ; check_time= 0. }
+  in
+  if (Int.Map.is_empty prf) then
+    report
+  else
+    let () = validate prf init in
+    let validated = Unix.gettimeofday () in
+    let aprf = minimize_abs_proof prf init in
+    let minimised = Unix.gettimeofday () in
+    let report =
+      { report with
+        min_size= size aprf
+      ; validate_time= validated -. start
+      ; minimise_time= minimised -. validated }
+    in
+    if (Int.Map.is_empty aprf) then
+      report
+    else
+      let () = validate aprf init in
+      let revalidated = Unix.gettimeofday () in
+      let sound, cache = cached_check init prf aprf in
+      { report with
+        sound
+      ; cache
+      ; validate_time= report.validate_time +. (revalidated -. minimised)
+      ; check_time= Unix.gettimeofday () -. revalidated }
@@ -17,11 +17,44 @@ val mk_abs_node :
     NB the root is always at 0. *)
 type t = abstract_node Int.Map.t
 
+val build_node :
+  Int.Set.t -> (int * (int * int) list * (int * int) list) list -> abstract_node
+(** [build_node tags premises] constructs a node directly from integer tags
+    and a list of triples of successor, valid and progressing tag pairs. *)
+
 val build_proof :
   (int * int list * (int * (int * int) list * (int * int) list) list) list -> t
 
 val check_proof : ?init:int -> t -> bool
-(** Validate, minimise, check soundness of proof/graph and memoise. *)
+(** Validate, minimise, check soundness of proof/graph and memoise.  Raises
+    [Invalid_argument], saying why, if the proof is not a valid graph. *)
+
+val check_live_proof : t -> Int.Set.t -> bool
+(** [check_live_proof prf live] is [check_proof prf], given the set [live] of
+    the nodes other than the root 0 from which an infinite path starts, i.e.
+    those that minimisation does not remove as dead.  Only those nodes and
+    the root are looked at, and only the minimised proof is validated. *)
+
+(** Whether a soundness verdict was found in the cache, computed and added
+    to it, or not needed because the proof minimised away entirely. *)
+type cache_status = Hit | Miss | Bypassed
+
+(** Breakdown of a single soundness check. Sizes are pairs of node and edge
+    counts; times are wall-clock seconds. *)
+type report =
+  { sound: bool
+  ; size: int * int
+  ; min_size: int * int
+  ; cache: cache_status
+  ; validate_time: float
+  ; minimise_time: float
+  ; check_time: float }
+
+val check_proof_report : ?init:int -> t -> report
+(** As [check_proof], but also report the sizes of the proof before and after
+    minimisation, cache behaviour and the time spent in each phase.  Raises
+    [Invalid_argument] as [check_proof].  Neither prints anything unless
+    debugging. *)
 
 val pp : Format.formatter -> t -> unit
 (** Pretty print abstract proof. *)
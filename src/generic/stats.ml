@@ -66,6 +66,99 @@ end
 
 module MCCache = CacheStats ()
 
+module Transpositions = CacheStats ()
+
+module Lemmas = CacheStats ()
+
+module Nogoods = CacheStats ()
+
+module BasePairs = CacheStats ()
+
+module Frontier = struct
+  let peak = ref 0
+
+  let expanded = ref 0
+
+  let overflows = ref 0
+
+  let record size = if Stdlib.( > ) size !peak then peak := size
+
+  let expand () = incr expanded
+
+  let overflow () = incr overflows
+
+  let reset () =
+    peak := 0 ;
+    expanded := 0 ;
+    overflows := 0
+end
+
+(* Opt-in profile of the proof rules, keyed by their names or else by the *)
+(* description of the applications they produce *)
+module Rules = struct
+  type entry =
+    { mutable calls: int
+    ; mutable apps: int
+    ; mutable subgoals: int
+    ; mutable checks: int
+    ; mutable time: float }
+
+  let enabled = ref false
+
+  let json_path = ref ""
+
+  (* soundness checks performed by back-link rules *)
+  let soundness_checks = ref 0
+
+  let table : (string, entry) Hashtbl.t = Hashtbl.create 53
+
+  let record descr ~apps ~subgoals ~checks time =
+    let e =
+      match Hashtbl.find_opt table descr with
+      | Some e -> e
+      | None ->
+          let e = {calls= 0; apps= 0; subgoals= 0; checks= 0; time= 0.0} in
+          Hashtbl.add table descr e ; e
+    in
+    e.calls <- e.calls + 1 ;
+    e.apps <- e.apps + apps ;
+    e.subgoals <- e.subgoals + subgoals ;
+    e.checks <- e.checks + checks ;
+    e.time <- e.time +. time
+
+  (* most expensive first *)
+  let entries () =
+    List.sort
+      (fun (_, e) (_, e') -> Stdlib.compare e'.time e.time)
+      (Hashtbl.fold (fun descr e acc -> (descr, e) :: acc) table [])
+
+  let print () =
+    Printf.printf "RULES: %-32s %9s %9s %9s %9s %9s\n" "Rule" "Calls" "Apps"
+      "Subgoals" "Checks" "Time(ms)" ;
+    List.iter
+      (fun (descr, e) ->
+        Printf.printf "RULES: %-32s %9d %9d %9d %9d %9.0f\n" descr e.calls
+          e.apps e.subgoals e.checks (1000.0 *. e.time) )
+      (entries ())
+
+  let write_json path =
+    let oc = open_out path in
+    output_string oc "[" ;
+    List.iteri
+      (fun i (descr, e) ->
+        Printf.fprintf oc
+          "%s\n  {\"rule\": %s, \"calls\": %d, \"apps\": %d, \
+           \"subgoals\": %d, \"checks\": %d, \"time_ms\": %.3f}"
+          (if Int.equal i 0 then "" else ",")
+          (Lib.Strng.to_json descr) e.calls e.apps e.subgoals e.checks
+          (1000.0 *. e.time) )
+      (entries ()) ;
+    output_string oc "\n]\n" ;
+    close_out oc
+
+  let reset () = soundness_checks := 0 ; Hashtbl.reset table
+end
+
 let gen_print () =
   if !do_statistics then (
     Printf.printf "GENERAL: Elapsed process time: %.0f ms\n"
@@ -80,6 +173,15 @@ let gen_print () =
       !MCCache.queries ;
     Printf.printf "MCCACHE: Time spent caching: %.0f ms \n"
       (1000.0 *. !MCCache.cpu_time) ;
+    Printf.printf "TTABLE: Hits: %d out of %d queries.\n"
+      !Transpositions.hits !Transpositions.queries ;
+    Printf.printf "NOGOODS: Hits: %d out of %d queries.\n" !Nogoods.hits
+      !Nogoods.queries ;
+    Printf.printf "LEMMADB: Hits: %d out of %d queries.\n" !Lemmas.hits
+      !Lemmas.queries ;
+    Printf.printf
+      "FRONTIER: Expanded %d states, peak size %d, overflowed %d times.\n"
+      !Frontier.expanded !Frontier.peak !Frontier.overflows ;
     Printf.printf "SLSAT: Total time spent: %.0f ms\n" (1000.0 *. !CC.cpu_time) ;
     Printf.printf "SLSAT: Percentage of process time spent: %.0f%%\n"
       ( if Stdlib.( = ) !Gen.cpu_time 0. then 0.
@@ -87,17 +189,26 @@ let gen_print () =
     Printf.printf
       "SLSAT: %d out of %d predicate definitions were inconsistent.\n"
       !CC.rejects !CC.calls ;
+    Printf.printf "SLSAT: Base pairs of %d out of %d strata were cached.\n"
+      !BasePairs.hits !BasePairs.queries ;
     Printf.printf "INVAL: Total time spent: %.0f ms\n"
       (1000.0 *. !Invalidity.cpu_time) ;
     Printf.printf "INVAL: Percentage of process time spent: %.0f%%\n"
       ( if Stdlib.( = ) !Gen.cpu_time 0. then 0.
       else 100.0 *. !Invalidity.cpu_time /. !Gen.cpu_time ) ;
     Printf.printf "INVAL: Found as invalid %d out of %d calls.\n"
-      !Invalidity.rejects !Invalidity.calls )
+      !Invalidity.rejects !Invalidity.calls ;
+    if !Rules.enabled then Rules.print () )
 
 let reset () =
   Gen.reset () ;
   MC.reset () ;
   CC.reset () ;
   MCCache.reset () ;
+  Transpositions.reset () ;
+  Lemmas.reset () ;
+  Nogoods.reset () ;
+  BasePairs.reset () ;
+  Frontier.reset () ;
+  Rules.reset () ;
   Invalidity.reset ()
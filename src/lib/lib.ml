@@ -17,6 +17,7 @@ module Treemap      = Treemap
 module Treeset      = Treeset
 module Unification  = Unification
 module VarManager   = VarManager
+module Worker       = Worker
 module Zlist        = Zlist
 
 include Misc
@@ -112,6 +112,13 @@ let w_timeout f (timeout : int) =
     reset_sigalrm () ; Some res
   with Timeout -> reset_sigalrm () ; None
 
+(* For a child process to call straight after [Unix.fork]: an interruption
+   that the parent maps to [Timeout] must kill the child, not make it carry
+   on as the parent. *)
+let default_interrupts () =
+  Sys.set_signal Sys.sigint Sys.Signal_default ;
+  Sys.set_signal Sys.sigterm Sys.Signal_default
+
 open MParser
 
 let rexp = MParser_RE.make_regexp "[a-zA-Z][_0-9a-zA-Z]*[']?"
@@ -14,3 +14,17 @@ end
 
 include StringType
 include Containers.Make (StringType)
+
+let to_json s =
+  let buf = Buffer.create (String.length s + 2) in
+  Buffer.add_char buf '"' ;
+  String.iter
+    (function
+      | '"' -> Buffer.add_string buf "\\\""
+      | '\\' -> Buffer.add_string buf "\\\\"
+      | c when Stdlib.( < ) (Char.code c) 0x20 ->
+          Buffer.add_string buf (Printf.sprintf "\\u%04x" (Char.code c))
+      | c -> Buffer.add_char buf c )
+    s ;
+  Buffer.add_char buf '"' ;
+  Buffer.contents buf
@@ -12,3 +12,7 @@ include
   with type Hashset.elt = t
   with type MSet.elt = t
   with type FList.t = t list
+
+val to_json : t -> string
+(** [to_json s] is the JSON string literal for [s], quotes included, with
+    quotes, backslashes and control characters escaped. *)
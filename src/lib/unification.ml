@@ -70,6 +70,46 @@ struct
     unify T.empty
 end
 
+(** [bucketed key_equal key mk total xs ys] unifies the lists [xs] and [ys]
+    linearly, one bucket at a time: [mk total bs bs'] unifies the elements
+    [bs] of [xs] with the elements [bs'] of [ys] having an equal [key].
+    Elements with distinct keys must never unify.  Fails without searching
+    if some bucket of [xs] is larger than the corresponding one of [ys], or
+    if [total] and some bucket sizes differ. *)
+let bucketed key_equal key mk total xs ys cont init_state =
+  let group zs =
+    List.fold_left
+      (fun groups z ->
+        let k = key z in
+        let rec insert = function
+          | [] -> [(k, [z])]
+          | (k', zs) :: groups when key_equal k k' -> (k', z :: zs) :: groups
+          | group :: groups -> group :: insert groups
+        in
+        insert groups )
+      [] zs
+  in
+  let xgroups = group xs in
+  let ygroups = group ys in
+  let bucket k groups =
+    match List.find_opt (fun (k', _) -> key_equal k k') groups with
+    | Some (_, zs) -> zs
+    | None -> []
+  in
+  let fits (k, xs) =
+    let c = List.compare_lengths xs (bucket k ygroups) in
+    if total then Stdlib.( = ) c 0 else Stdlib.( <= ) c 0
+  in
+  let covered (k, _) = List.exists (fun (k', _) -> key_equal k k') xgroups in
+  if
+    List.for_all fits xgroups
+    && ((not total) || List.for_all covered ygroups)
+  then
+    List.fold_left
+      (fun cont (k, xs) -> mk total xs (bucket k ygroups) cont)
+      cont xgroups init_state
+  else None
+
 (** cps-style unifier combinators *)
 
 (** [backtrack u] takes a cps-style unifier [u] and produces a
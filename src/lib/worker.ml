@@ -0,0 +1,51 @@
+type t = {pid: int; requests: out_channel; answers: in_channel}
+
+let spawn ?(siblings = []) work =
+  (* children must not inherit output still to be flushed *)
+  flush stdout ;
+  flush stderr ;
+  let req_r, req_w = Unix.pipe () in
+  let ans_r, ans_w = Unix.pipe () in
+  match Unix.fork () with
+  | 0 ->
+      Misc.default_interrupts () ;
+      List.iter
+        (fun w -> close_out_noerr w.requests ; close_in_noerr w.answers)
+        siblings ;
+      Unix.close req_w ;
+      Unix.close ans_r ;
+      let oc = Unix.out_channel_of_descr ans_w in
+      (try work (Unix.in_channel_of_descr req_r) oc with _ -> ()) ;
+      close_out_noerr oc ;
+      exit 0
+  | pid ->
+      Unix.close req_r ;
+      Unix.close ans_w ;
+      { pid
+      ; requests= Unix.out_channel_of_descr req_w
+      ; answers= Unix.in_channel_of_descr ans_r }
+
+let send w x = Marshal.to_channel w.requests x [] ; flush w.requests
+
+let receive w =
+  try Some (Marshal.from_channel w.answers) with End_of_file | Failure _ ->
+    None
+
+let rec select inputs ws =
+  let descr w = Unix.descr_of_in_channel w.answers in
+  match Unix.select (inputs @ List.map descr ws) [] [] (-1.0) with
+  | exception Unix.Unix_error (Unix.EINTR, _, _) -> select inputs ws
+  | fds, _, _ ->
+      ( List.filter (fun fd -> List.memq fd fds) inputs
+      , List.filter (fun w -> List.memq (descr w) fds) ws )
+
+let ready ws = snd (select [] ws)
+
+let shutdown ws =
+  List.iter
+    (fun w ->
+      (try Unix.kill w.pid Sys.sigkill with Unix.Unix_error _ -> ()) ;
+      close_out_noerr w.requests ;
+      close_in_noerr w.answers ;
+      try ignore (Unix.waitpid [] w.pid) with Unix.Unix_error _ -> () )
+    ws
@@ -0,0 +1,33 @@
+(** Worker processes, forked off to compute in parallel and talking to their
+    parent over pipes with [Marshal].  The data a worker needs is shared by
+    forking, so requests and answers are best kept to small values such as
+    indices; in particular, hash-consed values cannot be passed. *)
+
+type t = {pid: int; requests: out_channel; answers: in_channel}
+
+val spawn : ?siblings:t list -> (in_channel -> out_channel -> unit) -> t
+(** [spawn ~siblings work] forks a worker running [work requests answers],
+    where [requests] reads what the parent [send]s and the parent [receive]s
+    what is written to [answers].  Output still buffered is flushed first, so
+    that the worker does not print it again.  In the worker, SIGINT and
+    SIGTERM get their default handling back and the channels to [siblings]
+    are closed.  The worker exits once [work] returns or raises any
+    exception, so it never returns into the code of its parent. *)
+
+val send : t -> 'a -> unit
+
+val receive : t -> 'a option
+(** The next value the worker answers, or [None] if it exited without
+    answering, e.g. as it failed.  As [Marshal], this is not type-safe. *)
+
+val ready : t list -> t list
+(** Block until some of the workers have answered or exited, and return
+    those.  Signals raising no exception do not interrupt the wait. *)
+
+val select : Unix.file_descr list -> t list -> Unix.file_descr list * t list
+(** As [ready], but also waiting for input on the given descriptors, and
+    returning those with input along with the workers. *)
+
+val shutdown : t list -> unit
+(** Kill the workers still running, close the channels to them and reap
+    them. *)
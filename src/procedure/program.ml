@@ -255,6 +255,8 @@ module Seq = struct
     Format.fprintf fmt "@[%s{%a}@ %a@ {%a}@]" symb_turnstile.sep Form.pp pre
       (Cmd.pp ~abbr:true 0) cmd Form.pp post
 
+  let size (pre, cmd, post) = Form.size pre + Blist.length cmd + Form.size post
+
   (* Tags.pp (tags seq) *)
 
   let equal (pre, cmd, post) (pre', cmd', post') =
@@ -265,6 +267,11 @@ module Seq = struct
     && Form.equal_upto_tags pre pre'
     && Form.equal_upto_tags post post'
 
+  let hash_upto_tags (pre, cmd, post) =
+    genhash
+      (genhash (Form.hash_upto_tags pre) (Cmd.hash cmd))
+      (Form.hash_upto_tags post)
+
   let dest (pre, cmd, post) = (Form.dest pre, cmd, Form.dest post)
 
   let get_tracepairs (pre, _, _) (pre', _, _) =
@@ -133,6 +133,13 @@ let () =
   (*   If not While_program.well_formed defs prog then F.die !While_program.error_msg *)
   Program.set_program (fields, procs) ;
   Rules.setup (defs, procs, proc_proofs) ;
+  Lemmadb.context :=
+    Digest.to_hex (Digest.file !defs_path)
+    ^ Digest.to_hex (Digest.file !prog_path)
+    ^ " -Lem "
+    ^ string_of_int (Seplog.Rules.lemma_level_to_int !Seplog.Rules.lemma_level)
+    ^ " -ed " ^ string_of_int !Rules.entl_depth
+    ^ if !Program.termination then " -T" else "" ;
   let proc_names = Blist.map Proc.get_name procs in
   let entry_points =
     if !prove_all then proc_names
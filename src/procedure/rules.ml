@@ -49,10 +49,22 @@ let entails f f' =
       let () = debug (fun _ -> "Entailment is invalid!") in
       None
     else
+      let key = "entails " ^ Seplog.Seq.normalised_string seq in
+      let stored =
+        if Lemmadb.enabled () then
+          Slprover.lookup !Rules.axioms !Rules.rules depth key seq
+        else None
+      in
       let dbg = !do_debug in
       let prf =
         do_debug := !do_debug && !show_entailment_debug ;
-        Slprover.idfs 1 depth !Rules.axioms !Rules.rules seq
+        match stored with
+        | Some prf -> prf
+        | None ->
+            let prf = Slprover.idfs 1 depth !Rules.axioms !Rules.rules seq in
+            if Lemmadb.enabled () then
+              Slprover.remember !Rules.axioms !Rules.rules depth key prf ;
+            prf
       in
       do_debug := dbg ;
       let () =
@@ -124,53 +124,366 @@ module BaseAndRule = struct
   include Containers.Make (T)
 end
 
-module Attempted = Hashset.Make (BaseAndRule.FList)
+(* The base pairs of a predicate, kept as an antichain under [leq]: a pair *)
+(* above one already there is not added, and a pair added evicts those *)
+(* above it.  Only pairs over the same formals are compared.  Along [leq] *)
+(* neither the number of equalities nor that of allocated terms decreases, *)
+(* so pairs are bucketed by formals and then by these two counts, and only *)
+(* the buckets with no greater (resp. no smaller) counts are searched for *)
+(* pairs below (resp. above) a new one. *)
+module Antichain = struct
+  module FormalsTbl = Hashtbl.Make (Term.FList)
+
+  type t =
+    { members: BaseAndRule.Hashset.t
+    ; buckets: (int * int, BaseAndRule.t list) Hashtbl.t FormalsTbl.t }
+
+  let create n =
+    {members= BaseAndRule.Hashset.create n; buckets= FormalsTbl.create n}
+
+  let size (v, h) = (Blist.length (Uf.bindings h.SH.eqs), Allocated.cardinal v)
+
+  let buckets_of s fs =
+    match FormalsTbl.find_opt s.buckets fs with
+    | Some b -> b
+    | None ->
+        let b = Hashtbl.create 11 in
+        FormalsTbl.add s.buckets fs b ;
+        b
+
+  let mem s x = BaseAndRule.Hashset.mem s.members x
+
+  let is_empty s = BaseAndRule.Hashset.is_empty s.members
+
+  let iter f s =
+    FormalsTbl.iter
+      (fun _ b -> Hashtbl.iter (fun _ xs -> Blist.iter f xs) b)
+      s.buckets
+
+  let to_list s =
+    let res = ref [] in
+    iter (fun x -> res := x :: !res) s ;
+    !res
+
+  (* true iff [x] was added *)
+  let add s ((bp, fs) as x) =
+    if mem s x then false
+    else
+      let e, a = size bp in
+      let b = buckets_of s fs in
+      let below =
+        Hashtbl.fold
+          (fun (e', a') ys found ->
+            found
+            || Int.( <= ) e' e
+               && Int.( <= ) a' a
+               && Blist.exists (fun (bp', _) -> BasePair.leq bp' bp) ys )
+          b false
+      in
+      if below then false
+      else (
+        Hashtbl.filter_map_inplace
+          (fun (e', a') ys ->
+            if Int.( < ) e' e || Int.( < ) a' a then Some ys
+            else
+              let above, ys =
+                Blist.partition (fun (bp', _) -> BasePair.leq bp bp') ys
+              in
+              Blist.iter (BaseAndRule.Hashset.remove s.members) above ;
+              Option.mk (not (Blist.is_empty ys)) ys )
+          b ;
+        Hashtbl.replace b (e, a)
+          (x :: Option.dest [] Fun.id (Hashtbl.find_opt b (e, a))) ;
+        BaseAndRule.Hashset.add s.members x ;
+        true )
+end
+
 include BasePair
 module RuleMap = Treemap.Make (Indrule)
 module PredMap = Treemap.Make (Predsym)
+module PredGraph = Graph.Persistent.Digraph.Concrete (Predsym)
+module PredComponents = Graph.Components.Make (PredGraph)
 
-let gen_pair case cbps s s' att =
-  if Attempted.mem att cbps then ()
-  else
-    match gen case cbps with
-    | None -> ()
-    | Some bp ->
-        Hashset.add s bp ;
-        BaseAndRule.Hashset.add s' (bp, Indrule.formals case) ;
-        Attempted.add att cbps
+let jobs = ref 1
+
+(* record the base pair generated, if any and new to [case], and whether it *)
+(* is minimal among those of the predicate of [case] so far *)
+let gen_pair case cbps s s' fresh record =
+  match gen case cbps with
+  | Some bp when not (Hashset.mem s bp) ->
+      Hashset.add s bp ;
+      let bpr = (bp, Indrule.formals case) in
+      record cbps bpr ;
+      if Antichain.add s' bpr then fresh := bpr :: !fresh
+  | _ -> ()
 
 let choose_iter f ys =
   let rec aux f acc = function
     | [] -> f acc
-    | xs :: tl -> BaseAndRule.Hashset.iter (fun x -> aux f (x :: acc) tl) xs
+    | xs :: tl -> Blist.iter (fun x -> aux f (x :: acc) tl) xs
   in
   aux f [] (Blist.rev ys)
 
+let find_pairs p m = Option.dest [] Fun.id (PredMap.find_opt p m)
+
+let body_preds case =
+  Tpreds.map_to_list (fun (_, (p, _)) -> p) (Indrule.body case).SH.inds
+
+(* The fixpoint is computed semi-naively: [old] holds the base pairs of each *)
+(* predicate known before the last round and [delta] those found in it, so *)
+(* that a round only considers the combinations using at least one pair of *)
+(* [delta].  Each such combination is enumerated exactly once, by taking the *)
+(* pair at the first position that draws from [delta], pairs from [old] *)
+(* before it and from either after it. *)
+let gen_pairs fire case old delta =
+  let preds = body_preds case in
+  Blist.iteri
+    (fun i p ->
+      if not (Blist.is_empty (find_pairs p delta)) then
+        choose_iter fire
+          (Blist.mapi
+             (fun j p' ->
+               let o = find_pairs p' old in
+               if Int.( < ) j i then o
+               else if Int.equal j i then find_pairs p' delta
+               else Blist.rev_append (find_pairs p' delta) o )
+             preds) )
+    preds
+
+(* Saturate the [rules] of the stratum defining [preds], given the pairs *)
+(* [known] of the predicates of lower strata, which are never revisited. *)
+(* [record i cbps bpr] is called on every pair [bpr] new to the [i]th rule, *)
+(* generated out of [cbps]. *)
 (* the f argument is a unit-taking function that checks if we can stop *)
 (* due to first predicate being non-empty *)
-let gen_pairs f case cmap pmap attmap =
-  let h, (pred, _) = Indrule.dest case in
-  let candidates =
-    Tpreds.map_to_list (fun (_, (i, _)) -> PredMap.find i pmap) h.SH.inds
+let saturate f cmap pmap known preds rules record =
+  let new_pairs () =
+    Blist.fold_left (fun m p -> PredMap.add p (ref []) m) PredMap.empty preds
+  in
+  let fire fresh i case cbps =
+    f () ;
+    let p = Indrule.predsym case in
+    gen_pair case cbps (RuleMap.find case cmap) (PredMap.find p pmap)
+      (PredMap.find p fresh) (record i)
+  in
+  (* pairs evicted from an antichain during a round are dropped after it *)
+  let minimal p = Blist.filter (Antichain.mem (PredMap.find p pmap)) in
+  let found fresh = PredMap.mapi (fun p r -> minimal p !r) fresh in
+  let rec loop old delta =
+    debug (fun () -> "\n" ^ RuleMap.to_string Hashset.to_string cmap ^ "\n") ;
+    if PredMap.exists (fun _ d -> not (Blist.is_empty d)) delta then (
+      let fresh = new_pairs () in
+      Blist.iteri (fun i c -> gen_pairs (fire fresh i c) c old delta) rules ;
+      let old =
+        PredMap.mapi
+          (fun p o ->
+            if PredMap.mem p delta then
+              minimal p (Blist.rev_append (PredMap.find p delta) o)
+            else o )
+          old
+      in
+      loop old (found fresh) )
+  in
+  (* the first round is naive, as nothing is known of [preds] yet *)
+  let fresh = new_pairs () in
+  Blist.iteri
+    (fun i c ->
+      choose_iter (fire fresh i c)
+        (Blist.map (fun p -> find_pairs p known) (body_preds c)) )
+    rules ;
+  loop
+    (Blist.fold_left (fun m p -> PredMap.add p [] m) known preds)
+    (found fresh)
+
+(* The strongly connected components of the dependency graph of the *)
+(* predicates of [defs], grouped by level: a component only depends on *)
+(* itself and on components of lower levels, so the components of a level *)
+(* can be computed independently once those below them have converged. *)
+(* Each component comes with a key digesting its definitions and the keys *)
+(* of the components it depends on, and so all the definitions relevant *)
+(* to it. *)
+let strata defs =
+  let g =
+    Defs.rule_fold
+      (fun g r ->
+        Blist.fold_left
+          (fun g q ->
+            if Defs.mem q defs then PredGraph.add_edge g (Indrule.predsym r) q
+            else g )
+          (PredGraph.add_vertex g (Indrule.predsym r))
+          (body_preds r) )
+      PredGraph.empty defs
+  in
+  let n, comp_of = PredComponents.scc g in
+  let comps = Array.make n [] in
+  PredGraph.iter_vertex
+    (fun p -> comps.(comp_of p) <- p :: comps.(comp_of p))
+    g ;
+  let comps =
+    Array.map
+      (Blist.sort (fun p q ->
+           Strng.compare (Predsym.to_string p) (Predsym.to_string q) ))
+      comps
   in
-  let s = RuleMap.find case cmap in
-  let s' = PredMap.find pred pmap in
-  let att = RuleMap.find case attmap in
-  choose_iter
-    (fun cbps ->
-      f () ;
-      gen_pair case cbps s s' att )
-    candidates
+  let levels = Array.make n (-1) in
+  let rec level i =
+    if Int.( < ) levels.(i) 0 then
+      levels.(i) <-
+        Blist.fold_left
+          (fun l p ->
+            PredGraph.fold_succ
+              (fun q l ->
+                let j = comp_of q in
+                if Int.equal i j then l else Int.max l (level j + 1) )
+              g p l )
+          0 comps.(i) ;
+    levels.(i)
+  in
+  let keys = Array.make n None in
+  let rec key i =
+    match keys.(i) with
+    | Some k -> k
+    | None ->
+        let below =
+          Blist.fold_left
+            (fun ks p ->
+              PredGraph.fold_succ
+                (fun q ks ->
+                  let j = comp_of q in
+                  if Int.equal i j then ks else Strng.Set.add (key j) ks )
+                g p ks )
+            Strng.Set.empty comps.(i)
+        in
+        let rules = Blist.bind (fun p -> Defs.get_def p defs) comps.(i) in
+        let k =
+          Digest.to_hex
+            (Digest.string
+               (String.concat "\n"
+                  ( Blist.map Indrule.to_string rules
+                  @ Strng.Set.to_list below )))
+        in
+        keys.(i) <- Some k ;
+        k
+  in
+  let top = Array.fold_left Int.max 0 (Array.init n level) in
+  let by_level = Array.make (top + 1) [] in
+  for i = n - 1 downto 0 do
+    by_level.(levels.(i)) <- (comps.(i), key i) :: by_level.(levels.(i))
+  done ;
+  Array.to_list by_level
+
+(* A pair generated by the [i]th rule of a stratum out of [cbps], with all *)
+(* pairs given as printed.  Pairs cannot be marshalled, as the terms they *)
+(* consist of are hash-consed, so workers answer with derivations that the *)
+(* parent replays. *)
+type derivation = int * string list * string
+
+(* Worker [w] of [n] saturates every [n]th stratum from the [w]th on.  A *)
+(* worker that fails answers nothing, leaving its strata to the parent. *)
+let par_derive derive strata =
+  let strata = Array.of_list strata in
+  let n = Int.min !jobs (Array.length strata) in
+  let spawn w =
+    let saturate _ oc =
+      let rec aux k res =
+        if Int.( >= ) k (Array.length strata) then res
+        else aux (k + n) ((k, derive strata.(k)) :: res)
+      in
+      Marshal.to_channel oc (aux w [] : (int * derivation list) list) []
+    in
+    Worker.spawn saturate
+  in
+  let workers = Blist.init n spawn in
+  let derivations = Array.make (Array.length strata) None in
+  let rec collect = function
+    | [] -> ()
+    | wk :: rest as workers ->
+        ( match (Worker.receive wk : (int * derivation list) list option) with
+        | res ->
+            Option.iter
+              (Blist.iter (fun (k, ds) -> derivations.(k) <- Some ds))
+              res
+        | exception e -> Worker.shutdown workers ; raise e ) ;
+        Worker.shutdown [wk] ;
+        collect rest
+  in
+  collect workers ;
+  Blist.combine (Array.to_list strata) (Array.to_list derivations)
+
+(* Saturated strata, by key, as the pairs of each of their predicates and *)
+(* those of each of their rules, in order.  Flushed once full. *)
+type saturated =
+  {pairs: (Predsym.t * BaseAndRule.t list) list; rule_pairs: t list list}
+
+let cache : (string, saturated) Hashtbl.t = Hashtbl.create 53
+
+let cache_limit = 4096
+
+let clear_cache () = Hashtbl.reset cache
+
+let cache_path = ref ""
+
+(* the strata in [!cache_path], as the derivations replaying them *)
+let read_stored () : (string, derivation list) Hashtbl.t =
+  match open_in_bin !cache_path with
+  | exception Sys_error _ -> Hashtbl.create 53
+  | ic ->
+      let table =
+        try (Marshal.from_channel ic : (string, derivation list) Hashtbl.t)
+        with End_of_file | Failure _ -> Hashtbl.create 53
+      in
+      close_in ic ; table
+
+(* strata stored by this process, still to be written out *)
+let unsaved : (string, derivation list) Hashtbl.t = Hashtbl.create 53
+
+let save_stored () =
+  if Int.( > ) (Hashtbl.length unsaved) 0 then (
+    (* other runs may have written to the file since it was read *)
+    let table = read_stored () in
+    Hashtbl.iter (Hashtbl.replace table) unsaved ;
+    let tmp = !cache_path ^ "." ^ string_of_int (Unix.getpid ()) in
+    let oc = open_out_bin tmp in
+    Marshal.to_channel oc table [] ;
+    close_out oc ;
+    Sys.rename tmp !cache_path ;
+    Hashtbl.reset unsaved )
+
+let stored = ref None
+
+let stored_table () =
+  match !stored with
+  | Some table -> table
+  | None ->
+      let table = read_stored () in
+      let owner = Unix.getpid () in
+      stored := Some table ;
+      (* processes forked by the workers exit too *)
+      at_exit (fun () ->
+          if Int.equal (Unix.getpid ()) owner then save_stored () ) ;
+      table
+
+let storing () = not (String.equal !cache_path "")
+
+let find_stored key =
+  if storing () then Hashtbl.find_opt (stored_table ()) key else None
+
+let store key ds =
+  if storing () then (
+    Hashtbl.replace (stored_table ()) key ds ;
+    Hashtbl.replace unsaved key ds )
 
 let first_pred_not_empty defs =
   let defs = Defs.to_list defs in
   let first_pred = Preddef.predsym (Blist.hd defs) in
-  fun pmap -> not (BaseAndRule.Hashset.is_empty (PredMap.find first_pred pmap))
+  fun pmap -> not (Antichain.is_empty (PredMap.find first_pred pmap))
 
 exception FirstNonEmpty
 
 let gen_all_pairs ?(only_first = false) defs =
   let first_not_empty = first_pred_not_empty defs in
+  let rules_of comp = Blist.bind (fun p -> Defs.get_def p defs) comp in
+  let strata = strata defs in
   let defs = Defs.to_list defs in
   let cmap =
     Blist.fold_left
@@ -180,50 +493,178 @@ let gen_all_pairs ?(only_first = false) defs =
           m (Preddef.rules d) )
       RuleMap.empty defs
   in
-  let get_sizemap cmap =
-    RuleMap.fold
-      (fun c s m -> RuleMap.add c (Hashset.cardinal s) m)
-      cmap RuleMap.empty
-  in
   let pmap =
     Blist.fold_left
-      (fun m d ->
-        let first = Blist.hd (Preddef.rules d) in
-        PredMap.add (Indrule.predsym first)
-          (BaseAndRule.Hashset.create 11)
-          m )
+      (fun m d -> PredMap.add (Preddef.predsym d) (Antichain.create 11) m)
       PredMap.empty defs
   in
-  let att =
-    Blist.fold_left
-      (fun m d ->
-        Blist.fold_left
-          (fun m' c -> RuleMap.add c (Attempted.create 11) m')
-          m (Preddef.rules d) )
-      RuleMap.empty defs
-  in
-  let progress = ref true in
   (* f is passed down to gen_pairs so that execution can terminate immediately *)
   (* once the first predicate is non-empty, if asked by the caller. *)
   (* this is meant to happen during iteration as opposed to after each approximant *)
   (* has been computed. *)
   (* NB we can do the below without arguments only because the key-to-value *)
   (* relationship is immutable, and as values are mutable. *)
+  (* Only the stratum of the first predicate can be cut short, and it is *)
+  (* then not cached. *)
   let f () = if only_first && first_not_empty pmap then raise FirstNonEmpty in
-  let sizemap = ref (get_sizemap cmap) in
+  let known = ref PredMap.empty in
+  let by_name = Hashtbl.create 997 in
+  let run comp record =
+    saturate f cmap pmap !known comp (rules_of comp) record
+  in
+  let finish comp =
+    Blist.iter
+      (fun p ->
+        let s = PredMap.find p pmap in
+        known := PredMap.add p (Antichain.to_list s) !known ;
+        if Int.( > ) !jobs 1 || storing () then
+          Antichain.iter
+            (fun x -> Hashtbl.replace by_name (BaseAndRule.to_string x) x)
+            s )
+      comp
+  in
+  let derive comp =
+    let names = BaseAndRule.Hashmap.create 997 in
+    let name x =
+      match BaseAndRule.Hashmap.find_opt names x with
+      | Some s -> s
+      | None ->
+          let s = BaseAndRule.to_string x in
+          BaseAndRule.Hashmap.add names x s ;
+          s
+    in
+    let log = ref [] in
+    run comp (fun i cbps bpr ->
+        log := (i, Blist.map name cbps, name bpr) :: !log ) ;
+    Blist.rev !log
+  in
+  (* the pairs are only added once every derivation has been checked *)
+  let replay comp ds =
+    let rules = Array.of_list (rules_of comp) in
+    let rec check staged = function
+      | [] ->
+          Blist.iter
+            (fun (c, ((bp, _) as bpr)) ->
+              Hashset.add (RuleMap.find c cmap) bp ;
+              ignore
+                (Antichain.add (PredMap.find (Indrule.predsym c) pmap) bpr) )
+            (Blist.rev staged) ;
+          true
+      | (i, cbps, name) :: ds -> (
+          let c = rules.(i) in
+          match
+            Option.map
+              (fun bp -> (bp, Indrule.formals c))
+              (gen c (Blist.map (Hashtbl.find by_name) cbps))
+          with
+          | Some bpr when String.equal (BaseAndRule.to_string bpr) name ->
+              Hashtbl.replace by_name name bpr ;
+              check ((c, bpr) :: staged) ds
+          | _ -> false
+          | exception Not_found -> false )
+    in
+    check [] ds
+  in
+  let restore comp c =
+    Blist.iter2
+      (fun r bps -> Blist.iter (Hashset.add (RuleMap.find r cmap)) bps)
+      (rules_of comp) c.rule_pairs ;
+    Blist.iter
+      (fun (p, xs) ->
+        let s = PredMap.find p pmap in
+        Blist.iter (fun x -> ignore (Antichain.add s x)) xs )
+      c.pairs
+  in
+  let remember comp key =
+    if Int.( >= ) (Hashtbl.length cache) cache_limit then Hashtbl.reset cache ;
+    Hashtbl.replace cache key
+      { pairs=
+          Blist.map (fun p -> (p, Antichain.to_list (PredMap.find p pmap))) comp
+      ; rule_pairs=
+          Blist.map
+            (fun r -> Hashset.to_list (RuleMap.find r cmap))
+            (rules_of comp) }
+  in
+  let no_record _ _ _ = () in
+  (* [derived] are the derivations of the stratum by a worker, if any *)
+  let settle ((comp, key), derived) =
+    ( match Hashtbl.find_opt cache key with
+    | Some c -> Stats.BasePairs.hit () ; restore comp c
+    | None ->
+        if Option.pred_dest (replay comp) (find_stored key) then
+          Stats.BasePairs.hit ()
+        else (
+          Stats.BasePairs.miss () ;
+          match derived with
+          | Some ds when replay comp ds -> store key ds
+          | _ ->
+              if storing () then store key (derive comp)
+              else run comp no_record ) ;
+        remember comp key ) ;
+    finish comp
+  in
   let () =
     try
-      while !progress do
-        debug (fun () -> "\n" ^ RuleMap.to_string Hashset.to_string cmap ^ "\n") ;
-        RuleMap.iter (fun c _ -> gen_pairs f c cmap pmap att) cmap ;
-        let newsizemap = get_sizemap cmap in
-        progress := not (RuleMap.equal Int.equal !sizemap newsizemap) ;
-        sizemap := newsizemap
-      done
+      Blist.iter
+        (fun level ->
+          let todo, saturated =
+            Blist.partition
+              (fun (_, key) ->
+                not
+                  ( Hashtbl.mem cache key
+                  || Option.is_some (find_stored key) ) )
+              level
+          in
+          let derived =
+            if Int.( > ) !jobs 1 && Int.( > ) (Blist.length todo) 1 then
+              par_derive (fun (comp, _) -> derive comp) todo
+            else Blist.map (fun s -> (s, None)) todo
+          in
+          Blist.iter settle
+            (Blist.map (fun s -> (s, None)) saturated @ derived) )
+        strata
     with FirstNonEmpty -> ()
   in
   (cmap, pmap)
 
+let pairs_of_defs defs =
+  let _, pmap = gen_all_pairs defs in
+  PredMap.to_list (PredMap.map Antichain.to_list pmap)
+
+(* The plain fixpoint iteration the above refines: every rule is fired on *)
+(* every combination of all the pairs known, until a round adds none. *)
+let naive_pairs_of_defs defs =
+  let pmap =
+    Blist.fold_left
+      (fun m d ->
+        PredMap.add (Preddef.predsym d) (BaseAndRule.Hashset.create 11) m )
+      PredMap.empty (Defs.to_list defs)
+  in
+  let known p =
+    Option.dest [] BaseAndRule.Hashset.to_list (PredMap.find_opt p pmap)
+  in
+  let rules = Blist.rev (Defs.rule_fold (fun rs r -> r :: rs) [] defs) in
+  let rec loop () =
+    let progress = ref false in
+    Blist.iter
+      (fun case ->
+        let s = PredMap.find (Indrule.predsym case) pmap in
+        choose_iter
+          (fun cbps ->
+            match gen case cbps with
+            | Some bp ->
+                let bpr = (bp, Indrule.formals case) in
+                if not (BaseAndRule.Hashset.mem s bpr) then (
+                  BaseAndRule.Hashset.add s bpr ;
+                  progress := true )
+            | None -> () )
+          (Blist.map known (body_preds case)) )
+      rules ;
+    if !progress then loop ()
+  in
+  loop () ;
+  PredMap.to_list (PredMap.map BaseAndRule.Hashset.to_list pmap)
+
 (* NB correctness relies on rules being explicit about x->_ implying       *)
 (* x!=nil !!!                                                              *)
 let satisfiable ?(only_first = false) ?(output = false) defs =
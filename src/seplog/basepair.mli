@@ -12,6 +12,21 @@ module Hashset : Hashset.S with type elt = t
 
 val vars : t -> Term.Set.t
 
+val jobs : int ref
+(** Number of worker processes the strata of a base pair computation that do
+    not depend on each other are split between, defaults to [1], i.e. a
+    sequential computation. *)
+
+val cache_path : string ref
+(** A file storing the base pairs computed, so that later runs over the same
+    definitions need not compute them again; the empty string, the default,
+    disables it.  Within a run, the base pairs of a set of definitions are
+    only computed once regardless. *)
+
+val clear_cache : unit -> unit
+(** Forget the base pairs computed so far in this run, though not those
+    stored in [!cache_path]. *)
+
 val satisfiable : ?only_first:bool -> ?output:bool -> Defs.t -> bool
 (** See [gen_all_pairs] regarding [~only_first]. 
 
@@ -34,3 +49,12 @@ val leq : t -> t -> bool
     fixed representatives of equivalence classes induced by [h]. *)
 
 val minimise : Set.t -> Set.t
+
+val pairs_of_defs : Defs.t -> (Predsym.t * (t * Term.t list) list) list
+(** The base pairs of each predicate of the definitions, as an antichain
+    under [leq], along with the formals of the rule each was generated by. *)
+
+val naive_pairs_of_defs : Defs.t -> (Predsym.t * (t * Term.t list) list) list
+(** Like [pairs_of_defs] but keeping every base pair, computed by firing every
+    rule on every combination of the pairs known until nothing new comes up.
+    Only meant as a reference to test [pairs_of_defs] against. *)
@@ -12,7 +12,7 @@ let show_proof = ref false
 
 let usage =
   "usage: " ^ Sys.argv.(0)
-  ^ " [-p/d/s/f/-Z] [-t <int>] [-D <file>] [-S <string>]"
+  ^ " [-p/d/s/f/-Z] [-t/j <int>] [-D/bp <file>] [-S <string>]"
 
 let timeout = ref 60
 
@@ -30,6 +30,13 @@ let speclist =
   ; ( "-S"
     , Arg.Set_string cl_sequent
     , ": disprove the SL sequent provided in <string>" )
+  ; ( "-j"
+    , Arg.Set_int Invalid.jobs
+    , ": search for a witness with <int> processes, default is "
+      ^ string_of_int !Invalid.jobs )
+  ; ( "-bp"
+    , Arg.Set_string Basepair.cache_path
+    , ": look up base pairs in, and record new ones to, the cache <file>" )
   ; ( "-IP"
     , Arg.Set Invalid.partition_strengthening
     , ": use partition strengthening in invalidity heuristic, default is "
@@ -60,7 +67,20 @@ let () =
     else Some (call ())
   in
   Stats.Gen.end_call () ;
-  if !Stats.do_statistics then Stats.gen_print () ;
+  if !Stats.do_statistics then (
+    Stats.gen_print () ;
+    Blist.iter
+      (fun {Invalid.worker; tried; elapsed; finished} ->
+        if finished then
+          Printf.printf
+            "INVAL: Worker %d tried %d base pairs in %.0f ms (%.1f per s)\n"
+            worker tried (1000.0 *. elapsed)
+            ( if Stdlib.( = ) elapsed 0. then 0.
+            else float_of_int tried /. elapsed )
+        else Printf.printf "INVAL: Worker %d was cancelled\n" worker )
+      (Blist.sort
+         (fun s s' -> Int.compare s.Invalid.worker s'.Invalid.worker)
+         !Invalid.last_workers) ) ;
   let exit_code =
     match res with
     | None ->
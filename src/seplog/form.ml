@@ -47,6 +47,9 @@ let tags (cs, d) =
 
 let tag_pairs f = Tagpairs.mk (tags f)
 
+let size (cs, d) =
+  Blist.foldl (fun n h -> n + Heap.size h) (Ord_constraints.cardinal cs) d
+
 let inconsistent (cs, f) =
   Ord_constraints.inconsistent cs || Blist.for_all Heap.inconsistent f
 
@@ -101,6 +104,11 @@ let subsumed_upto_tags ?(total = true) (cs, hs) (cs', hs') =
 let equal_upto_tags (cs, hs) (cs', hs') =
   Blist.for_all2 Heap.equal_upto_tags hs hs'
 
+let hash_upto_tags (_, hs) =
+  Blist.fold_left
+    (fun h heap -> genhash h (Heap.hash_upto_tags heap))
+    0x9e3779b9 hs
+
 let parse ?(null_is_emp = false) ?(allow_tags = true) ?(augment_deqs = true) st
     =
   ( (if allow_tags then option Ord_constraints.parse else return None)
@@ -25,6 +25,10 @@ val equal_upto_tags : t -> t -> bool
 (** Whilst [equal] demands syntactic equality including tags, this version
     ignores tag assignment. *)
 
+val hash_upto_tags : t -> int
+(** Hash function compatible with [equal_upto_tags]; in particular the
+    ordinal constraints are not hashed. *)
+
 val terms : t -> Term.Set.t
 
 val vars : t -> Term.Set.t
@@ -36,6 +40,9 @@ val tags : t -> Tags.t
 val tag_pairs : t -> Tagpairs.t
 (** The proviso on tags applies here too. *)
 
+val size : t -> int
+(** Number of atoms in all disjuncts plus the number of tag constraints. *)
+
 val complete_tags : Tags.t -> t -> t
 (** [complete_tags ts f] returns the formula obtained from f by assigning
     all untagged predicates a fresh existential tag, avoiding those in [ts].
@@ -11,25 +11,63 @@ type abstract1 = Term.Set.t option
 
 type abstract2 = Tags.t option
 
+(* numbers of points-tos and predicates, along with one-word Bloom filters *)
+(* of the numbers of fields of the former and the symbols of the latter *)
+type fingerprint = {npto: int; nind: int; arities: int; predsyms: int}
+
+type abstract3 = fingerprint option
+
 type symheap =
   { eqs: Uf.t
   ; deqs: Deqs.t
   ; ptos: Ptos.t
   ; inds: Tpreds.t
+  ; _hash: int
   ; mutable _terms: Term.Set.t option
   ; mutable _vars: Term.Set.t option
-  ; mutable _tags: Tags.t option }
+  ; mutable _tags: Tags.t option
+  ; mutable _fingerprint: fingerprint option }
 
 type t = symheap
 
+(* Symbolic heaps are hash-consed: [mk] below returns the existing heap *)
+(* structurally equal to the one requested, if there is one, so that *)
+(* equality is physical and the hash is computed once.  The table is weak *)
+(* so heaps no longer referenced elsewhere can be collected. *)
+module Shared = Weak.Make (struct
+  type t = symheap
+
+  let equal h h' =
+    Uf.equal h.eqs h'.eqs
+    && Deqs.equal h.deqs h'.deqs
+    && Ptos.equal h.ptos h'.ptos
+    && Tpreds.equal h.inds h'.inds
+
+  let hash h = h._hash
+end)
+
+let shared = Shared.create 1031
+
+let mk eqs deqs ptos inds =
+  Shared.merge shared
+    { eqs
+    ; deqs
+    ; ptos
+    ; inds
+    ; _hash=
+        genhash
+          (genhash
+             (genhash (Tpreds.hash inds) (Ptos.hash ptos))
+             (Deqs.hash deqs))
+          (Uf.hash eqs)
+    ; _terms= None
+    ; _vars= None
+    ; _tags= None
+    ; _fingerprint= None }
+
 (* accessors *)
 
-let equal h h' =
-  h == h'
-  || Uf.equal h.eqs h'.eqs
-     && Deqs.equal h.deqs h'.deqs
-     && Ptos.equal h.ptos h'.ptos
-     && Tpreds.equal h.inds h'.inds
+let equal h h' = h == h'
 
 let equal_upto_tags h h' =
   h == h'
@@ -57,13 +95,12 @@ let compare f g =
         | n when not (Int.equal n 0) -> n
         | _ -> Tpreds.compare f.inds g.inds ) )
 
-(* custom hash function so that memoization fields are ignored when hashing *)
-(* so that the hash invariant is preserved [a = b => hash(a) = hash(b)] *)
-(* FIXME: memoize hash as well? *)
-let hash h =
+let hash h = h._hash
+
+let hash_upto_tags h =
   genhash
     (genhash
-       (genhash (Tpreds.hash h.inds) (Ptos.hash h.ptos))
+       (genhash (Tpreds.hash_upto_tags h.inds) (Ptos.hash h.ptos))
        (Deqs.hash h.deqs))
     (Uf.hash h.eqs)
 
@@ -99,6 +136,43 @@ let tags h =
 
 let tag_pairs f = Tagpairs.mk (tags f)
 
+let bloom_bit n = 1 lsl (n land max_int mod 62)
+
+let fingerprint h =
+  match h._fingerprint with
+  | Some fp -> fp
+  | None ->
+      let fp =
+        { npto= Ptos.cardinal h.ptos
+        ; nind= Tpreds.cardinal h.inds
+        ; arities=
+            Ptos.fold
+              (fun (_, args) bits -> bits lor bloom_bit (Blist.length args))
+              h.ptos 0
+        ; predsyms=
+            Tpreds.fold
+              (fun ind bits ->
+                bits lor bloom_bit (Predsym.hash (Tpred.predsym ind)) )
+              h.inds 0 }
+      in
+      h._fingerprint <- Some fp ;
+      fp
+
+let spatially_fits ?(total = true) h h' =
+  let fp = fingerprint h in
+  let fp' = fingerprint h' in
+  let within bits bits' = Int.equal (bits land lnot bits') 0 in
+  if total then
+    Int.equal fp.npto fp'.npto
+    && Int.equal fp.nind fp'.nind
+    && Int.equal fp.arities fp'.arities
+    && Int.equal fp.predsyms fp'.predsyms
+  else
+    Int.( <= ) fp.npto fp'.npto
+    && Int.( <= ) fp.nind fp'.nind
+    && within fp.arities fp'.arities
+    && within fp.predsyms fp'.predsyms
+
 let has_untagged_preds h = not (Tpreds.for_all Tpred.is_tagged h.inds)
 
 let to_string f =
@@ -138,23 +212,26 @@ let inconsistent h =
 
 let idents p = Tpreds.idents p.inds
 
+let size h =
+  Blist.length (Uf.bindings h.eqs)
+  + Deqs.cardinal h.deqs + Ptos.cardinal h.ptos + Tpreds.cardinal h.inds
+
 let subsumed_upto_tags ?(total = true) h h' =
-  Uf.subsumed h.eqs h'.eqs
+  spatially_fits ~total h h'
+  && Uf.subsumed h.eqs h'.eqs
   && Deqs.subsumed h'.eqs h.deqs h'.deqs
   && Ptos.subsumed ~total h'.eqs h.ptos h'.ptos
   && Tpreds.subsumed_upto_tags ~total h'.eqs h.inds h'.inds
 
 let subsumed ?(total = true) h h' =
-  Uf.subsumed h.eqs h'.eqs
+  spatially_fits ~total h h'
+  && Uf.subsumed h.eqs h'.eqs
   && Deqs.subsumed h'.eqs h.deqs h'.deqs
   && Ptos.subsumed ~total h'.eqs h.ptos h'.ptos
   && Tpreds.subsumed ~total h'.eqs h.inds h'.inds
 
 (* Constructors *)
 
-let mk eqs deqs ptos inds =
-  {eqs; deqs; ptos; inds; _terms= None; _vars= None; _tags= None}
-
 let dest h = (h.eqs, h.deqs, h.ptos, h.inds)
 
 let empty = mk Uf.empty Deqs.empty Ptos.empty Tpreds.empty
@@ -162,19 +239,16 @@ let empty = mk Uf.empty Deqs.empty Ptos.empty Tpreds.empty
 let is_empty h = equal h empty
 
 let subst theta h =
-  { eqs= Uf.subst theta h.eqs
-  ; deqs= Deqs.subst theta h.deqs
-  ; ptos= Ptos.subst theta h.ptos
-  ; inds= Tpreds.subst theta h.inds
-  ; _terms= None
-  ; _vars= None
-  ; _tags= None }
+  mk (Uf.subst theta h.eqs)
+    (Deqs.subst theta h.deqs)
+    (Ptos.subst theta h.ptos)
+    (Tpreds.subst theta h.inds)
 
-let with_eqs h eqs = {h with eqs; _terms= None; _vars= None; _tags= None}
+let with_eqs h eqs = mk eqs h.deqs h.ptos h.inds
 
-let with_deqs h deqs = {h with deqs; _terms= None; _vars= None; _tags= None}
+let with_deqs h deqs = mk h.eqs deqs h.ptos h.inds
 
-let with_ptos h ptos = {h with ptos; _terms= None; _vars= None; _tags= None}
+let with_ptos h ptos = mk h.eqs h.deqs ptos h.inds
 
 let with_inds h inds = mk h.eqs h.deqs h.ptos inds
 
@@ -182,25 +256,15 @@ let del_deq h deq = with_deqs h (Deqs.remove deq h.deqs)
 
 let del_pto h pto = with_ptos h (Ptos.remove pto h.ptos)
 
-let del_ind h ind =
-  { h with
-    inds= Tpreds.remove ind h.inds; _terms= None; _vars= None; _tags= None
-  }
+let del_ind h ind = with_inds h (Tpreds.remove ind h.inds)
 
-let mk_pto pto =
-  { empty with
-    ptos= Ptos.singleton pto; _terms= None; _vars= None; _tags= None }
+let mk_pto pto = with_ptos empty (Ptos.singleton pto)
 
-let mk_eq p =
-  { empty with
-    eqs= Uf.add p Uf.empty; _terms= None; _vars= None; _tags= None }
+let mk_eq p = with_eqs empty (Uf.add p Uf.empty)
 
-let mk_deq p =
-  {empty with deqs= Deqs.singleton p; _terms= None; _vars= None; _tags= None}
+let mk_deq p = with_deqs empty (Deqs.singleton p)
 
-let mk_ind pred =
-  { empty with
-    inds= Tpreds.singleton pred; _terms= None; _vars= None; _tags= None }
+let mk_ind pred = with_inds empty (Tpreds.singleton pred)
 
 let proj_sp h = mk Uf.empty Deqs.empty h.ptos h.inds
 
@@ -278,11 +342,9 @@ let parse ?(allow_tags = true) ?(augment_deqs = true) st =
 let of_string ?(allow_tags = true) ?(augment_deqs = true) s =
   handle_reply (MParser.parse_string (parse ~allow_tags ~augment_deqs) s ())
 
-let add_eq h eq =
-  {h with eqs= Uf.add eq h.eqs; _terms= None; _vars= None; _tags= None}
+let add_eq h eq = with_eqs h (Uf.add eq h.eqs)
 
-let add_deq h deq =
-  {h with deqs= Deqs.add deq h.deqs; _terms= None; _vars= None; _tags= None}
+let add_deq h deq = with_deqs h (Deqs.add deq h.deqs)
 
 let add_pto h pto = star h (mk_pto pto)
 
@@ -305,22 +367,17 @@ let subst_existentials h =
       in
       let eqs = Blist.filter (fun eq' -> eq' != eq) eqs in
       let x, y = if Term.is_exist_var x then eq else (y, x) in
-      let h' =
-        {h with eqs= Uf.of_list eqs; _terms= None; _vars= None; _tags= None}
-      in
+      let h' = with_eqs h (Uf.of_list eqs) in
       subst (Term.Map.singleton x y) h'
     with Not_found -> h
   in
   fixpoint aux h
 
 let norm h =
-  { h with
-    deqs= Deqs.norm h.eqs h.deqs
-  ; ptos= Ptos.norm h.eqs h.ptos
-  ; inds= Tpreds.norm h.eqs h.inds
-  ; _terms= None
-  ; _vars= None
-  ; _tags= None }
+  mk h.eqs
+    (Deqs.norm h.eqs h.deqs)
+    (Ptos.norm h.eqs h.ptos)
+    (Tpreds.norm h.eqs h.inds)
 
 (* FIXME review *)
 let project f xs =
@@ -343,11 +400,7 @@ let project f xs =
     Uf.fold do_eq h.eqs h
   in
   let proj_deqs g =
-    { g with
-      deqs= Deqs.filter (fun p -> not (pair_nin_lst p)) g.deqs
-    ; _terms= None
-    ; _vars= None
-    ; _tags= None }
+    with_deqs g (Deqs.filter (fun p -> not (pair_nin_lst p)) g.deqs)
   in
   proj_deqs (proj_eqs f)
 
@@ -359,38 +412,46 @@ let subst_tags tagpairs h = with_inds h (Tpreds.subst_tags tagpairs h.inds)
 
 let unify_partial ?(tagpairs = true) ?(update_check = Fun._true) h h' cont
     init_state =
-  (Tpreds.unify ~total:false ~tagpairs ~update_check h.inds h'.inds
-     (Ptos.unify ~total:false ~update_check h.ptos h'.ptos
-        (Deqs.unify_partial ~update_check h.deqs h'.deqs
-           (Uf.unify_partial ~update_check h.eqs h'.eqs cont))))
-    init_state
+  if not (spatially_fits ~total:false h h') then None
+  else
+    (Tpreds.unify ~total:false ~tagpairs ~update_check h.inds h'.inds
+       (Ptos.unify ~total:false ~update_check h.ptos h'.ptos
+          (Deqs.unify_partial ~update_check h.deqs h'.deqs
+             (Uf.unify_partial ~update_check h.eqs h'.eqs cont))))
+      init_state
 
 let biunify_partial ?(tagpairs = true) ?(update_check = Fun._true) h h' cont
     init_state =
-  (Tpreds.biunify ~total:false ~tagpairs ~update_check h.inds h'.inds
-     (Ptos.biunify ~total:false ~update_check h.ptos h'.ptos
-        (Deqs.biunify_partial ~update_check h.deqs h'.deqs
-           (Uf.biunify_partial ~update_check h.eqs h'.eqs cont))))
-    init_state
+  if not (spatially_fits ~total:false h h') then None
+  else
+    (Tpreds.biunify ~total:false ~tagpairs ~update_check h.inds h'.inds
+       (Ptos.biunify ~total:false ~update_check h.ptos h'.ptos
+          (Deqs.biunify_partial ~update_check h.deqs h'.deqs
+             (Uf.biunify_partial ~update_check h.eqs h'.eqs cont))))
+      init_state
 
 let classical_unify ?(inverse = false) ?(tagpairs = true)
     ?(update_check = Fun._true) h h' cont init_state =
-  let h_inv, h'_inv = Fun.direct inverse Pair.mk h h' in
-  (* NB how we don't need an "inverse" version for ptos and inds, since *)
-  (* we unify the whole multiset, not a subformula *)
-  (Tpreds.unify ~tagpairs ~update_check h_inv.inds h'_inv.inds
-     (Ptos.unify ~update_check h_inv.ptos h'_inv.ptos
-        (Deqs.unify_partial ~inverse ~update_check h.deqs h'.deqs
-           (Uf.unify_partial ~inverse ~update_check h.eqs h'.eqs cont))))
-    init_state
+  if not (spatially_fits h h') then None
+  else
+    let h_inv, h'_inv = Fun.direct inverse Pair.mk h h' in
+    (* NB how we don't need an "inverse" version for ptos and inds, since *)
+    (* we unify the whole multiset, not a subformula *)
+    (Tpreds.unify ~tagpairs ~update_check h_inv.inds h'_inv.inds
+       (Ptos.unify ~update_check h_inv.ptos h'_inv.ptos
+          (Deqs.unify_partial ~inverse ~update_check h.deqs h'.deqs
+             (Uf.unify_partial ~inverse ~update_check h.eqs h'.eqs cont))))
+      init_state
 
 let classical_biunify ?(tagpairs = true) ?(update_check = Fun._true) h h' cont
     init_state =
-  (Tpreds.biunify ~tagpairs ~update_check h.inds h'.inds
-     (Ptos.biunify ~update_check h.ptos h'.ptos
-        (Deqs.biunify_partial ~update_check h.deqs h'.deqs
-           (Uf.biunify_partial ~update_check h.eqs h'.eqs cont))))
-    init_state
+  if not (spatially_fits h h') then None
+  else
+    (Tpreds.biunify ~tagpairs ~update_check h.inds h'.inds
+       (Ptos.biunify ~update_check h.ptos h'.ptos
+          (Deqs.biunify_partial ~update_check h.deqs h'.deqs
+             (Uf.biunify_partial ~update_check h.eqs h'.eqs cont))))
+      init_state
 
 let all_subheaps h =
   let all_ptos = Ptos.subsets h.ptos in
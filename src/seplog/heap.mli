@@ -7,14 +7,18 @@ type abstract1
 
 type abstract2
 
+type abstract3
+
 type symheap = private
   { eqs: Uf.t
   ; deqs: Deqs.t
   ; ptos: Ptos.t
   ; inds: Tpreds.t
+  ; _hash: int
   ; mutable _terms: abstract1
   ; mutable _vars: abstract1
-  ; mutable _tags: abstract2 }
+  ; mutable _tags: abstract2
+  ; mutable _fingerprint: abstract3 }
 
 include BasicType with type t = symheap
 
@@ -58,12 +62,24 @@ val find_lval : Term.t -> t -> Pto.t option
 val idents : t -> Predsym.MSet.t
 (** Get multiset of predicate identifiers. *)
 
+val size : t -> int
+(** Number of atoms in the heap: equalities, disequalities, points-tos and
+    predicates. *)
+
 val inconsistent : t -> bool
 (** Trivially false if heap contains t!=t for any term t, or if x=y * x!=y
     is provable for any x,y.
     NB only equalities and disequalities are used for this check.
 *)
 
+val spatially_fits : ?total:bool -> t -> t -> bool
+(** [spatially_fits h h'] is a necessary condition, checked in constant time
+    once computed for each heap, for the points-tos and predicates of [h] to
+    match those of [h'] one to one, up to their arguments and tags.  If the
+    optional argument [~total=true] is set to [false] then it is one for them
+    to match some of those of [h'].  [subsumed], [subsumed_upto_tags] and the
+    unifiers below check it first. *)
+
 val subsumed : ?total:bool -> t -> t -> bool
 (** [subsumed h h'] is true iff [h] can be rewritten using the equalities
     in [h'] such that its spatial part becomes equal to that of [h']
@@ -79,11 +95,16 @@ val subsumed_upto_tags : ?total:bool -> t -> t -> bool
     of [h']. *)
 
 val equal : t -> t -> bool
-(** Checks whether two symbolic heaps are equal. *)
+(** Checks whether two symbolic heaps are equal.  Symbolic heaps are
+    hash-consed, so this is physical equality, and [hash] is precomputed. *)
 
 val equal_upto_tags : t -> t -> bool
 (** Like [equal] but ignoring tag assignment. *)
 
+val hash_upto_tags : t -> int
+(** Like [hash] but ignoring tag assignment, so compatible with
+    [equal_upto_tags]. *)
+
 val is_empty : t -> bool
 (** [is_empty h] tests whether [h] is equal to the empty heap. *)
 
@@ -3,7 +3,85 @@ open Generic
 
 let partition_strengthening = ref false
 
-let partitions trm_list pi =
+let jobs = ref 1
+
+type worker_stats = {worker: int; tried: int; elapsed: float; finished: bool}
+
+let last_workers = ref []
+
+(* Worker [w] of [n] tries every [n]th candidate from the [w]th on, and *)
+(* answers with the index of the first witness it finds, if any, along *)
+(* with the number of candidates it tried and the time it took.  The *)
+(* candidates are shared by forking, and only indices are passed back. *)
+let spawn_worker p candidates n w =
+  let search_stride _ oc =
+    let start = Unix.gettimeofday () in
+    let rec search i tried =
+      if Int.( >= ) i (Array.length candidates) then (None, tried)
+      else if p candidates.(i) then (Some i, tried + 1)
+      else search (i + n) (tried + 1)
+    in
+    let res, tried = search w 0 in
+    Marshal.to_channel oc
+      ((res, tried, Unix.gettimeofday () -. start) : int option * int * float)
+      []
+  in
+  (w, Worker.spawn search_stride)
+
+let par_find_opt p candidates =
+  let candidates = Array.of_list candidates in
+  let n = Int.min !jobs (Array.length candidates) in
+  let workers = Blist.init n (spawn_worker p candidates n) in
+  last_workers := [] ;
+  let shutdown () =
+    Worker.shutdown (Blist.map snd workers) ;
+    Blist.iter
+      (fun (w, _) ->
+        if not (Blist.exists (fun s -> Int.equal s.worker w) !last_workers)
+        then
+          last_workers :=
+            {worker= w; tried= 0; elapsed= 0.0; finished= false}
+            :: !last_workers )
+      workers
+  in
+  let rec loop running =
+    if Blist.is_empty running then None
+    else
+      let ready = Worker.ready (Blist.map snd running) in
+      let finished, running =
+        Blist.partition (fun (_, wk) -> Blist.memq wk ready) running
+      in
+      let answer (w, wk) =
+        (* a worker that died without answering found nothing *)
+        let res, tried, elapsed =
+          Option.dest (None, 0, 0.0) Fun.id
+            (Worker.receive wk : (int option * int * float) option)
+        in
+        last_workers :=
+          {worker= w; tried; elapsed; finished= true} :: !last_workers ;
+        res
+      in
+      match Blist.find_map answer finished with
+      | None -> loop running
+      | res -> res
+  in
+  let res =
+    try
+      let res = loop workers in
+      shutdown () ; res
+    with e -> shutdown () ; raise e
+  in
+  Option.map (fun i -> candidates.(i)) res
+
+(* The partitions are enumerated lazily and depth first, deciding one pair *)
+(* of terms at a time, so only the current branch is held in memory and *)
+(* the enumeration ends with the first partition the consumer accepts.  A *)
+(* pair already decided by the choices above it is not split on, as either *)
+(* choice would be inconsistent or redundant; as equating two classes *)
+(* clashes exactly when they are disequated, every branch stays *)
+(* consistent.  A branch is cut as soon as its partial partition satisfies *)
+(* [prune], which must then hold of every refinement of it too. *)
+let partitions ~prune trm_list pi =
   assert (not (Heap.inconsistent pi)) ;
   let pairs = Blist.cartesian_hemi_square trm_list in
   let pairs =
@@ -11,14 +89,20 @@ let partitions trm_list pi =
       (fun (x, y) -> not (Heap.equates pi x y || Heap.disequates pi x y))
       pairs
   in
-  let aux sub_partitions ((x, y) as q) =
-    Blist.fold_left
-      (fun l pi' ->
-        if Heap.equates pi' x y || Heap.disequates pi' x y then pi' :: l
-        else Heap.add_eq pi' q :: Heap.add_deq pi' q :: l )
-      [] sub_partitions
+  let rec aux pi' pairs =
+    if prune pi' then Zlist.empty
+    else
+      match pairs with
+      | [] -> Zlist.singleton pi'
+      | ((x, y) as q) :: pairs ->
+          if Heap.equates pi' x y || Heap.disequates pi' x y then
+            aux pi' pairs
+          else
+            Zlist.bind
+              (fun pi'' -> aux pi'' pairs)
+              (Zlist.of_list [Heap.add_eq pi' q; Heap.add_deq pi' q])
   in
-  Blist.fold_left aux [pi] pairs
+  aux pi pairs
 
 (* paper: GRAY CODES, LOOPLESS ALGORITHM AND PARTITIONS *)
 (* let _partitions n =                                                   *)
@@ -123,16 +207,24 @@ let invalidity_witness defs seq =
     let v, v' = Pair.map (map_through sigma) (v, v') in
     Basepair.Allocated.subset v' v
   in
-  let a_partition ((v, pi) as bp) sigma =
-    not (Basepair.Set.exists (fun bp' -> b_move sigma bp bp') rbps)
+  (* refining [sigma] only adds to the equalities and disequalities that *)
+  (* [b_move] looks for, and merges allocated terms on both sides alike, *)
+  (* so once a base pair moves from a partial partition it moves from all *)
+  (* its refinements, and any partition left is a witness *)
+  let moves bp sigma =
+    Basepair.Set.exists (fun bp' -> b_move sigma bp bp') rbps
   in
-  let a_move ((v, pi) as bp) =
+  let a_move ((_, pi) as bp) =
     let trms = trm_list bp in
-    Blist.exists
-      (fun sigma -> a_partition bp sigma)
-      (partitions trms (strengthen trms pi))
+    not
+      (Zlist.is_empty
+         (partitions ~prune:(moves bp) trms (strengthen trms pi)))
+  in
+  let result =
+    if Int.( > ) !jobs 1 && Int.( > ) (Basepair.Set.cardinal lbps) 1 then
+      par_find_opt a_move (Basepair.Set.to_list lbps)
+    else Basepair.Set.find_opt a_move lbps
   in
-  let result = Basepair.Set.find_opt a_move lbps in
   if Option.is_none result then Stats.Invalidity.reject ()
   else Stats.Invalidity.accept () ;
   result
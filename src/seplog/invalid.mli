@@ -2,6 +2,19 @@ val partition_strengthening : bool ref
 (** Use partition strengthening method when checking invalidity, 
     defaults to [false]. *)
 
+val jobs : int ref
+(** Number of worker processes [invalidity_witness] splits the candidate
+    base pairs of the LHS between, defaults to [1], i.e. a sequential
+    search.  The first witness found wins and the other workers are
+    killed, so the witness need not be the one found sequentially. *)
+
+type worker_stats = {worker: int; tried: int; elapsed: float; finished: bool}
+
+val last_workers : worker_stats list ref
+(** For each worker of the last parallel search, the number of candidates
+    it tried and the seconds it took, or [finished = false] if it was
+    killed before answering. *)
+
 val invalidity_witness : Defs.t -> Seq.t -> Basepair.t option
 
 val check : Defs.t -> Seq.t -> bool
@@ -42,8 +42,12 @@ module Make (Sig : Mc_core.ValueSig) = struct
 
     let equal_upto_tags = equal
 
+    let hash_upto_tags r = genhash (Stack.hash r.stack) (Heap.hash r.symheap)
+
     let tags _ = Tags.empty
 
+    let size r = Heap.size r.symheap
+
     let pp fmt r =
       Format.fprintf fmt "@[s, h %s %a -> h':%a@]"
         (* Stack.pp r.stack  *)
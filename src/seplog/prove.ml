@@ -79,6 +79,25 @@ let () =
       , Defs.of_channel (open_in !defs_path) )
   in
   Rules.setup defs ;
+  Lemmadb.context :=
+    Digest.to_hex (Digest.file (if slcomp_mode then !slcomp else !defs_path))
+    ^ " -Lem "
+    ^ string_of_int (Rules.lemma_level_to_int !Rules.lemma_level)
+    ^ if !Rules.use_invalidity_heuristic then " -IT" else "" ;
+  F.lemma_key := Seq.normalised_string ;
+  (* portfolio configurations running the invalidity heuristic during search *)
+  let with_invalidity ax r =
+    (ax, Rules.Rule.conditional (fun s -> not (Invalid.check defs s)) r)
+  in
+  F.portfolio :=
+    !F.portfolio
+    @ [ ("inval", with_invalidity)
+      ; ( "inval-partition"
+        , fun ax r ->
+            Invalid.partition_strengthening := true ;
+            with_invalidity ax r ) ] ;
+  F.portfolio_settings :=
+    F.saving Invalid.partition_strengthening :: !F.portfolio_settings ;
   let res =
     F.gather_stats (fun () ->
         if !invalidity_check && Invalid.check defs seq then None
@@ -24,15 +24,20 @@ let parse st =
   <?> "pto" )
     st
 
+(* points-tos can only unify if they have the same number of fields *)
+let by_arity u total ptos ptos' =
+  Unification.bucketed Int.equal
+    (fun (_, args) -> Blist.length args)
+    (fun total ps ps' -> mk_unifier total true u (of_list ps) (of_list ps'))
+    total (elements ptos) (elements ptos')
+
 let rec unify ?(total = true) ?(update_check = Fun._true) ptos ptos' cont
     init_state =
-  mk_unifier total true (Pto.unify ~update_check) ptos ptos' cont init_state
+  by_arity (Pto.unify ~update_check) total ptos ptos' cont init_state
 
 let rec biunify ?(total = true) ?(update_check = Fun._true) ptos ptos' cont
     init_state =
-  mk_unifier total true
-    (Pto.biunify ~update_check)
-    ptos ptos' cont init_state
+  by_arity (Pto.biunify ~update_check) total ptos ptos' cont init_state
 
 let rec subsumed ?(total = true) eqs ptos ptos' =
   if is_empty ptos then (not total) || is_empty ptos'
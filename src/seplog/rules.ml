@@ -31,6 +31,12 @@ let set_lemma_level level =
     | 3 -> ANY
     | _ -> raise (Arg.Bad "Unrecognised value for lemma application level")
 
+let lemma_level_to_int = function
+  | NO_LEMMAS -> 0
+  | ONLY_WITH_PREDICATES -> 1
+  | NON_EMPTY -> 2
+  | ANY -> 3
+
 let lemma_option_descr_str ?(line_prefix = "\t") () =
   let default_str level =
     if lemma_equal !lemma_level level then " (default)" else ""
@@ -49,7 +55,7 @@ let lemma_option_descr_str ?(line_prefix = "\t") () =
 (*       existentials (i.e. when the right-hand side is not simply subsumed   *)
 (*       the left-hand side). *)
 let id_axiom =
-  Rule.mk_axiom (fun ((cs, f), (cs', f')) ->
+  Rule.mk_axiom ~name:"Id" (fun ((cs, f), (cs', f')) ->
       let cs = Ord_constraints.close cs in
       Option.map
         (fun _ -> "Id")
@@ -73,14 +79,14 @@ let id_axiom =
 let preddefs = ref Defs.empty
 
 let ex_falso_axiom =
-  Rule.mk_axiom (fun (l, _) ->
+  Rule.mk_axiom ~name:"Ex Falso" (fun (l, _) ->
       Option.mk
         (Form.inconsistent l (*|| not (Basepair.form_sat !preddefs l)*))
         "Ex Falso" )
 
 (* break LHS disjunctions *)
 let lhs_disj_to_symheaps =
-  Rule.mk_infrule (fun ((cs, hs), r) ->
+  Rule.mk_infrule ~name:"L. Or" (fun ((cs, hs), r) ->
       match hs with
       | [] | [_] -> []
       | _ ->
@@ -102,7 +108,8 @@ let rhs_disj_to_symheaps_rl (((_, hs) as l), ((_, hs') as r)) =
           , "R. Or" ) )
         hs'
 
-let rhs_disj_to_symheaps = Rule.mk_infrule rhs_disj_to_symheaps_rl
+let rhs_disj_to_symheaps =
+  Rule.mk_infrule ~name:"R. Or" rhs_disj_to_symheaps_rl
 
 (* Left Instantiation Rules *)
 
@@ -136,7 +143,7 @@ let lhs_instantiate_seq =
   Seqtactics.relabel "LHS Inst."
     (Seqtactics.repeat (Seqtactics.first lhs_instantiation_rules))
 
-let lhs_instantiate = Rule.mk_infrule lhs_instantiate_seq
+let lhs_instantiate = Rule.mk_infrule ~name:"LHS Inst." lhs_instantiate_seq
 
 (* simplification rules *)
 
@@ -266,10 +273,10 @@ let simplify_seq =
   Seqtactics.relabel "Simplify"
     (Seqtactics.repeat (Seqtactics.first simplify_rules))
 
-let simplify = Rule.mk_infrule simplify_seq
+let simplify = Rule.mk_infrule ~name:"Simplify" simplify_seq
 
-let wrap r =
-  Rule.mk_infrule (Seqtactics.compose r (Seqtactics.attempt simplify_seq))
+let wrap ?name r =
+  Rule.mk_infrule ?name (Seqtactics.compose r (Seqtactics.attempt simplify_seq))
 
 (* do the following transformation for the first x such that *)
 (* x->y * A |- x->z * B     if     A |- y=z * B *)
@@ -298,7 +305,7 @@ let pto_intro_rule =
     with
     | Not_symheap | Not_found | Invalid_argument _ -> []
   in
-  wrap rl
+  wrap ~name:"Pto Intro" rl
 
 (* do the following transformation for the first P, (x_1,...,x_n) such that *)
 (*   P[a](x_1, ..., x_n) * A |- P[b](x_1, ..., x_n) * B    if  A |- B[a/b]  *)
@@ -352,7 +359,7 @@ let pred_intro_rule =
     with
     | Not_symheap | Not_found -> []
   in
-  wrap rl
+  wrap ~name:"Pred Intro" rl
 
 (* x->ys * A |- e->zs * B if  A |- ys=zs * B[x/e] where e existential *)
 (* and at least one var in ys,zs is the same *)
@@ -387,7 +394,7 @@ let instantiate_pto =
     with
     | Not_symheap | Invalid_argument _ -> []
   in
-  wrap rl
+  wrap ~name:"Inst Pto" rl
 
 (* ([a] <(=) [b], ...) : F |- ([c] <(=) [d], ...) : G            *)
 (*   if ([a] <(=) [b], ...) : F |- theta((...) : G)              *)
@@ -430,7 +437,7 @@ let constraint_match_tag_instantiate =
     in
     Option.dest [] Fun.id (Ord_constraints.find_map do_instantiation cs')
   in
-  wrap rl
+  wrap ~name:"Inst.Tag (Match)" rl
 
 (* F |- ([b'] <= [a] ...) : G  if  F |- theta((...) : G)           *)
 (*   where [a] universal, [b'] existential and theta = ([b'], [a]) *)
@@ -457,7 +464,7 @@ let upper_bound_tag_instantiate =
     let ruleapps = Tags.find_map do_instantiation ts in
     Option.dest [] Fun.id ruleapps
   in
-  wrap rl
+  wrap ~name:"Inst.Tag (Sel.UBound)" rl
 
 (* Lower and Upper Bound Constraint Introduction - do one of:               *)
 (*   A |- b' <= a_1, ..., b' <= a_n : B  if  A |- B                         *)
@@ -478,7 +485,7 @@ let bounds_intro_rl ((l, r) as seq) =
     Option.dest [] f result
   with Not_symheap -> []
 
-let bounds_intro = Rule.mk_infrule bounds_intro_rl
+let bounds_intro = Rule.mk_infrule ~name:"Bounds Intro" bounds_intro_rl
 
 let ruf_rl defs seq =
   try
@@ -507,7 +514,7 @@ let ruf_rl defs seq =
     Blist.flatten (Tpreds.map_to_list right_unfold r.SH.inds)
   with Not_symheap -> []
 
-let ruf defs = wrap (ruf_rl defs)
+let ruf defs = wrap ~name:"R.Unf." (ruf_rl defs)
 
 let luf defs =
   let rl seq =
@@ -543,7 +550,8 @@ let luf defs =
       Option.list_get (Tpreds.map_to_list left_unfold l.SH.inds)
     with Not_symheap -> []
   in
-  wrap (Seqtactics.compose rl (Seqtactics.attempt lhs_instantiate_seq))
+  wrap ~name:"L.Unf."
+    (Seqtactics.compose rl (Seqtactics.attempt lhs_instantiate_seq))
 
 (* seq' = (l',r') *)
 (* ------------   *)
@@ -1022,7 +1030,7 @@ let dobackl idx prf =
     Blist.map dest_taggedrule
       (Blist.stable_sort cmp_taggedrule (Blist.map f apps))
   in
-  Rule.first rules idx prf
+  Rule.first ~name:"Backl/Lemma" rules idx prf
 
 (* let axioms = ref (Rule.first [id_axiom ; ex_falso_axiom]) *)
 let axioms = ref Rule.fail
@@ -1042,7 +1050,7 @@ let setup defs =
       ; bounds_intro
       ; constraint_match_tag_instantiate
       ; upper_bound_tag_instantiate
-      ; Rule.choice
+      ; Rule.choice ~name:"Intro/Unf./Backl"
           [ dobackl
           ; pto_intro_rule
           ; pred_intro_rule
@@ -1056,7 +1064,7 @@ let setup defs =
                   cs )
               (ruf defs)
           ; luf defs ] ] ;
-  let axioms = Rule.first [id_axiom; ex_falso_axiom] in
+  let axioms = Rule.first ~name:"Axioms" [id_axiom; ex_falso_axiom] in
   rules := Rule.combine_axioms axioms !rules ;
   if !use_invalidity_heuristic then
     rules := Rule.conditional (fun s -> not (Invalid.check defs s)) !rules
@@ -23,6 +23,13 @@ let speclist =
       , Arg.Set_int timeout
       , ": set timeout in seconds to <int>, 0 disables it, default is "
         ^ string_of_int !timeout )
+    ; ( "-j"
+      , Arg.Set_int Basepair.jobs
+      , ": compute independent base pairs with <int> processes, default is "
+        ^ string_of_int !Basepair.jobs )
+    ; ( "-bp"
+      , Arg.Set_string Basepair.cache_path
+      , ": look up base pairs in, and record new ones to, the cache <file>" )
     ; ( "-f"
       , Arg.Set only_first
       , ": check satisfiability of first predicate only" )
@@ -37,7 +44,7 @@ let speclist =
 let usage =
   ref
     ( "usage: " ^ Sys.argv.(0)
-    ^ " [-p/d/s/f] [-t <int>] [-D <file>] [-SLCOMP <file>]" )
+    ^ " [-p/d/s/f] [-t/j <int>] [-D/bp <file>] [-SLCOMP <file>]" )
 
 let die msg =
   print_endline msg ;
@@ -12,6 +12,9 @@ let equal (l, r) (l', r') = Form.equal l l' && Form.equal r r'
 let equal_upto_tags (l, r) (l', r') =
   Form.equal_upto_tags l l' && Form.equal_upto_tags r r'
 
+let hash_upto_tags (l, r) =
+  genhash (Form.hash_upto_tags l) (Form.hash_upto_tags r)
+
 let dest seq = Pair.map Form.dest seq
 
 let to_string (l, r) =
@@ -47,6 +50,14 @@ let vars seq = Term.filter_vars (terms seq)
 
 let tags (l, r) = Tags.union (Form.tags l) (Form.tags r)
 
+let size (l, r) = Form.size l + Form.size r
+
+let normalised_string seq =
+  Lemmadb.normalise
+    ( Term.Set.map_to_list Term.to_string (vars seq)
+    @ Tags.map_to_list Tags.Elt.to_string (tags seq) )
+    (to_string seq)
+
 let tag_pairs (l, _) = Tagpairs.mk (Form.tags l)
 
 let get_tracepairs (l, _) (l', _) =
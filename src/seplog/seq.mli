@@ -7,6 +7,9 @@ include BasicType with type t = Form.t * Form.t
 val equal_upto_tags : t -> t -> bool
 (** Like [equal] but ignoring LHS tags as well as RHS ones. *)
 
+val hash_upto_tags : t -> int
+(** Hash function compatible with [equal_upto_tags]. *)
+
 val dest :
   t -> (Ord_constraints.t * Heap.t) * (Ord_constraints.t * Heap.t)
 (** If both LHS and RHS are symbolic heaps then return them else raise
@@ -21,6 +24,13 @@ val vars : t -> Term.Set.t
 val tags : t -> Tags.t
 (** Tags occurring in this sequent on both the LHS and RHS *)
 
+val size : t -> int
+(** Number of atoms and constraints on both the LHS and RHS. *)
+
+val normalised_string : t -> string
+(** The printed sequent with its variables and tags renamed in order of
+    occurrence, so that sequents equal up to such a renaming print alike. *)
+
 val tag_pairs : t -> Tagpairs.t
 (** Tag pairs constituting the identity relation on the tags in the LHS. *)
 
@@ -35,6 +35,8 @@ let strip_tags inds = map_to Pred.MSet.add Pred.MSet.empty snd inds
 let equal_upto_tags inds inds' =
   Pred.MSet.equal (strip_tags inds) (strip_tags inds')
 
+let hash_upto_tags inds = Pred.MSet.hash (strip_tags inds)
+
 let subst_tags tagpairs inds = map (Tpred.subst_tag tagpairs) inds
 
 let freshen_tags inds' inds =
@@ -53,17 +55,25 @@ let freshen_tags inds' inds =
       in
       map (fun (tag, head) -> (Tagpairs.apply_to_tag subst tag, head)) inds
 
+(* predicates can only unify if they have the same symbol and arity *)
+let by_predicate u total inds inds' =
+  Unification.bucketed
+    (fun (p, n) (p', n') -> Predsym.equal p p' && Int.equal n n')
+    (fun ind -> (Tpred.predsym ind, Blist.length (Tpred.args ind)))
+    (fun total ps ps' -> mk_unifier total true u (of_list ps) (of_list ps'))
+    total (elements inds) (elements inds')
+
 let unify ?(total = true) ?(tagpairs = true) ?(update_check = Fun._true) inds
     inds' cont init_state =
-  mk_unifier total true
+  by_predicate
     (Tpred.unify ~tagpairs ~update_check)
-    inds inds' cont init_state
+    total inds inds' cont init_state
 
 let biunify ?(total = true) ?(tagpairs = true) ?(update_check = Fun._true) inds
     inds' cont init_state =
-  mk_unifier total true
+  by_predicate
     (Tpred.biunify ~tagpairs ~update_check)
-    inds inds' cont init_state
+    total inds inds' cont init_state
 
 let subsumed_upto_tags ?(total = true) eqs inds inds' =
   let rec aux uinds uinds' =
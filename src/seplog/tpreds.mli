@@ -11,6 +11,9 @@ include OrderedContainer with type elt = Tpred.t
 val equal_upto_tags : t -> t -> bool
 (** Test whether the two arguments are the equal ignoring tags. *)
 
+val hash_upto_tags : t -> int
+(** Hash function compatible with [equal_upto_tags]. *)
+
 val subst : Subst.t -> t -> t
 
 val subst_tags : Tagpairs.t -> t -> t
@@ -2,19 +2,28 @@ open Lib
 open Symbols
 open MParser
 
-type t = Term.t Term.Map.t
+(* [parent] maps every term of a non-trivial class other than its *)
+(* representative directly to the representative, so that [find] takes a *)
+(* single lookup.  The representative is the greatest term of the class, *)
+(* which makes [parent] a canonical description of the partition, so the *)
+(* class that moves on a merge is fixed by [Tpair.order] and need not be *)
+(* the smaller one.  [members] maps each representative to the rest of *)
+(* its class, so that a merge touches only the entries of [parent] for *)
+(* the class that moves, rather than all of them. *)
+type t = {parent: Term.t Term.Map.t; members: Term.Set.t Term.Map.t}
 
-let equal u u' = Term.Map.equal Term.equal u u'
+(* [members] is determined by [parent] *)
+let equal u u' = u == u' || Term.Map.equal Term.equal u.parent u'.parent
 
-let compare m m' = Term.Map.compare Term.compare m m'
+let compare m m' = Term.Map.compare Term.compare m.parent m'.parent
 
-let hash m = Term.Map.hash Term.hash m
+let hash m = Term.Map.hash Term.hash m.parent
 
-let bindings m = Term.Map.bindings m
+let bindings m = Term.Map.bindings m.parent
 
-let empty = Term.Map.empty
+let empty = {parent= Term.Map.empty; members= Term.Map.empty}
 
-let is_empty = Term.Map.is_empty
+let is_empty m = Term.Map.is_empty m.parent
 
 let to_string_list v =
   Blist.map (Tpair.to_string_sep symb_eq.str) (bindings v)
@@ -30,26 +39,29 @@ let pp fmt v =
       Format.fprintf fmt "@[%a%s%a@]" Term.pp a symb_eq.str Term.pp b )
     fmt (bindings v)
 
-let fold f a uf = Term.Map.fold f a uf
+let fold f a uf = Term.Map.fold f a.parent uf
 
-let for_all f uf = Term.Map.for_all f uf
+let for_all f uf = Term.Map.for_all f uf.parent
 
-let rec find x m =
-  if Term.Map.mem x m then find (Term.Map.find x m) m else x
+let find x m = Option.dest x Fun.id (Term.Map.find_opt x m.parent)
+
+let class_of x m =
+  Option.dest Term.Set.empty Fun.id (Term.Map.find_opt x m.members)
 
 let add (x, y) m =
   let x, y = Tpair.order (find x m, find y m) in
   (* do not add trivial identities *)
   if Term.equal x y then m
   else
-    (* first split into the pairs that do not/do map to x *)
-    let to_x, rest = Term.Map.partition (fun _ z -> Term.equal z x) m in
-    (* now change all the values of keys that map to x to y *)
-    let to_y = Term.Map.map (fun _ -> y) to_x in
-    (* now union and add *)
-    Term.Map.add x y (Term.Map.union rest to_y)
+    (* the class of [x] joins that of [y] *)
+    let moved = Term.Set.add x (class_of x m) in
+    { parent= Term.Set.fold (fun z p -> Term.Map.add z y p) moved m.parent
+    ; members=
+        Term.Map.add y
+          (Term.Set.union moved (class_of y m))
+          (Term.Map.remove x m.members) }
 
-let union m m' = Term.Map.fold (fun x y m'' -> add (x, y) m'') m' m
+let union m m' = fold (fun x y m'' -> add (x, y) m'') m' m
 
 let of_list ls = Blist.fold_left (fun m pair -> add pair m) empty ls
 
@@ -65,10 +77,10 @@ let diff eqs eqs' =
   in
   of_list diffs_list
 
-let subsumed m m' = Term.Map.for_all (fun x y -> equates m' x y) m
+let subsumed m m' = for_all (fun x y -> equates m' x y) m
 
 let subst theta m =
-  Term.Map.fold (fun x y m' -> add (Tpair.subst theta (x, y)) m') m empty
+  fold (fun x y m' -> add (Tpair.subst theta (x, y)) m') m empty
 
 let terms m = Tpair.FList.terms (bindings m)
 
@@ -120,9 +132,10 @@ let subst_subsumed eqs ((theta, _) as state) =
 let remove x m =
   let xs = Term.Set.filter (equates m x) (vars m) in
   let rest =
-    Term.Map.filter
-      (fun y z -> not (Term.Set.mem y xs || Term.Set.mem z xs))
-      m
+    of_list
+      (Blist.filter
+         (fun (y, z) -> not (Term.Set.mem y xs || Term.Set.mem z xs))
+         (bindings m))
   in
   let xs' = Term.Set.to_list (Term.Set.remove x xs) in
   Blist.fold_left (fun m p -> add p m) rest (Blist.pairs xs')
@@ -11,6 +11,8 @@ val empty : t
 val is_empty : t -> bool
 
 val find : Term.t -> t -> Term.t
+(** The representative of the class of a term, found with a single lookup
+    since every term is kept linked directly to its representative. *)
 
 val add : Tpair.t -> t -> t
 
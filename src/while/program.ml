@@ -526,6 +526,13 @@ module Cmd = struct
       | _, Assert _ -> equal l tl'
       | _ -> cmd_equal c.cmd c'.cmd && equal tl tl' )
 
+  (* only the number of non-assertion commands at the top level, *)
+  (* as [equal] skips over assertions *)
+  let hash l =
+    Blist.fold_left
+      (fun n c -> match c.cmd with Assert _ -> n | _ -> n + 1)
+      0 l
+
   let rec subst_cmd theta cmd =
     match cmd with
     | Stop | Return | Skip | Assert _ -> cmd
@@ -697,11 +704,15 @@ module Seq = struct
     Format.fprintf fmt "@[%a%s%a@]" Form.pp f symb_turnstile.sep
       (Cmd.pp ~abbr:true 0) cmd
 
+  let size (f, cmd) = Form.size f + Blist.length cmd
+
   let equal (f, cmd) (f', cmd') = Cmd.equal cmd cmd' && Form.equal f f'
 
   let equal_upto_tags (f, cmd) (f', cmd') =
     Cmd.equal cmd cmd' && Form.equal_upto_tags f f'
 
+  let hash_upto_tags (f, cmd) = genhash (Form.hash_upto_tags f) (Cmd.hash cmd)
+
   let subsumed (f, cmd) (f', cmd') =
     Cmd.equal cmd cmd'
     && (if !termination then Form.subsumed else Form.subsumed_upto_tags)
@@ -51,4 +51,8 @@ let () =
   let prog = Cmd.number prog in
   set_program prog ;
   setup (Defs.of_channel (open_in !defs_path)) ;
+  Lemmadb.context :=
+    Digest.to_hex (Digest.file !defs_path)
+    ^ Digest.to_hex (Digest.file !prog_path)
+    ^ if !termination then " -T" else "" ;
   F.exit (F.prove_seq !axioms !rules (seq, prog))
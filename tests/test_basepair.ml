@@ -0,0 +1,118 @@
+open Lib
+open Generic
+open Seplog
+
+(* the definitions of the SL examples and of the SL satisfiability *)
+(* benchmarks, along with their base pairs as computed naively *)
+let defs =
+  let dir = "../benchmarks/slsat/cc" in
+  let read path =
+    let ic = open_in path in
+    let defs = Defs.of_channel ic in
+    close_in ic ;
+    (defs, Basepair.naive_pairs_of_defs defs)
+  in
+  Blist.map read
+    ( "../examples/sl.defs"
+    :: Blist.map (Filename.concat dir)
+         (Blist.sort String.compare
+            (Blist.filter
+               (fun f -> Filename.check_suffix f ".defs")
+               (Array.to_list (Sys.readdir dir)))) )
+
+let same (bp, fs) (bp', fs') =
+  Blist.equal Term.equal fs fs' && Basepair.equal bp bp'
+
+let below (bp, fs) (bp', fs') =
+  Blist.equal Term.equal fs fs' && Basepair.leq bp bp'
+
+(* every pair computed is a pair of the naive fixpoint, and every pair of *)
+(* the latter is above one computed *)
+let agree pairs naive =
+  Blist.for_all2
+    (fun (p, xs) (p', ys) ->
+      Predsym.equal p p'
+      && Blist.for_all (fun x -> Blist.exists (same x) ys) xs
+      && Blist.for_all (fun y -> Blist.exists (fun x -> below x y) xs) ys )
+    pairs naive
+
+let () =
+  runtest "Base pairs agree with the naive fixpoint." (fun () ->
+      Blist.iter
+        (fun (d, naive) ->
+          assert (agree (Basepair.pairs_of_defs d) naive) ;
+          let first = Preddef.predsym (Blist.hd (Defs.to_list d)) in
+          assert (
+            Bool.equal
+              (Basepair.satisfiable ~only_first:true d)
+              (Blist.exists
+                 (fun (p, ys) ->
+                   Predsym.equal p first && not (Blist.is_empty ys) )
+                 naive) ) ;
+          assert (
+            (not (Basepair.satisfiable d))
+            || Blist.for_all (fun (_, ys) -> not (Blist.is_empty ys)) naive )
+          )
+        defs )
+
+let () =
+  runtest "Strata saturated in parallel agree with the naive fixpoint."
+    (fun () ->
+      Blist.iter
+        (fun n ->
+          Basepair.clear_cache () ;
+          Basepair.jobs := n ;
+          Blist.iter
+            (fun (d, naive) -> assert (agree (Basepair.pairs_of_defs d) naive))
+            defs )
+        [2; 3] ;
+      Basepair.jobs := 1 )
+
+let () =
+  runtest "The base pairs kept for each predicate form an antichain."
+    (fun () ->
+      Blist.iter
+        (fun (d, _) ->
+          Blist.iter
+            (fun (_, xs) ->
+              Blist.iteri
+                (fun i x ->
+                  Blist.iteri
+                    (fun j y ->
+                      assert (Int.equal i j || not (below x y)) )
+                    xs )
+                xs )
+            (Basepair.pairs_of_defs d) )
+        defs )
+
+let () =
+  runtest "Base pairs read back from the caches agree with the naive fixpoint."
+    (fun () ->
+      let all_hits () =
+        let queries, hits = Stats.BasePairs.(!queries, !hits) in
+        Blist.iter
+          (fun (d, naive) -> assert (agree (Basepair.pairs_of_defs d) naive))
+          defs ;
+        Int.( > ) !Stats.BasePairs.queries queries
+        && Int.equal
+             (!Stats.BasePairs.queries - queries)
+             (!Stats.BasePairs.hits - hits)
+      in
+      (* within a run *)
+      Basepair.clear_cache () ;
+      ignore (all_hits ()) ;
+      assert (all_hits ()) ;
+      (* across runs, the first of which is a process of its own *)
+      Basepair.cache_path := Filename.temp_file "basepairs" "" ;
+      Sys.remove !Basepair.cache_path ;
+      Basepair.clear_cache () ;
+      ( match Unix.fork () with
+      | 0 -> ignore (all_hits ()) ; exit 0
+      | pid -> (
+        match Unix.waitpid [] pid with
+        | _, Unix.WEXITED 0 -> ()
+        | _ -> assert false ) ) ;
+      assert (Sys.file_exists !Basepair.cache_path) ;
+      assert (all_hits ()) ;
+      Sys.remove !Basepair.cache_path ;
+      Basepair.cache_path := "" )
@@ -0,0 +1,159 @@
+open Lib
+open Generic
+open Seplog
+
+(* every sequent of the base SL benchmarks *)
+let lines =
+  let dir = "../benchmarks/sl/base" in
+  let read f =
+    let ic = open_in (Filename.concat dir f) in
+    let rec aux acc =
+      match input_line ic with
+      | l -> aux (if String.equal (String.trim l) "" then acc else l :: acc)
+      | exception End_of_file -> close_in ic ; Blist.rev acc
+    in
+    aux []
+  in
+  Blist.bind read
+    (Blist.sort String.compare
+       (Blist.filter
+          (fun f -> Filename.check_suffix f ".tst")
+          (Array.to_list (Sys.readdir dir))))
+
+let heaps_of ((_, hs), (_, hs')) = hs @ hs'
+
+let heaps = Blist.bind (fun l -> heaps_of (Seq.of_string l)) lines
+
+let () =
+  runtest "Heaps built twice are the same heap." (fun () ->
+      assert (
+        Blist.for_all
+          (fun l ->
+            Blist.for_all2 Heap.equal
+              (heaps_of (Seq.of_string l))
+              (heaps_of (Seq.of_string l)) )
+          lines ) ;
+      assert (
+        Blist.for_all
+          (fun h ->
+            Heap.equal h
+              (Heap.star ~augment_deqs:false (Heap.proj_pure h)
+                 (Heap.proj_sp h)) )
+          heaps ) )
+
+let () =
+  runtest "Equality of heaps agrees with their comparison and hashes."
+    (fun () ->
+      Blist.iter
+        (fun h ->
+          Blist.iter
+            (fun h' ->
+              assert (
+                Bool.equal (Heap.equal h h') (Int.equal (Heap.compare h h') 0)
+              ) ;
+              assert (
+                (not (Heap.equal h h'))
+                || Int.equal (Heap.hash h) (Heap.hash h') ) ;
+              assert (
+                (not (Heap.equal_upto_tags h h'))
+                || Int.equal (Heap.hash_upto_tags h) (Heap.hash_upto_tags h')
+              ) )
+            heaps )
+        heaps )
+
+let () =
+  Random.init 0 ;
+  runtest "Union-find structures track classes and do not depend on order."
+    (fun () ->
+      let var i = Term.of_string ("x" ^ string_of_int i) in
+      let terms = Term.nil :: Blist.init 8 var in
+      let n = Blist.length terms in
+      let term i = Blist.nth terms i in
+      for _ = 1 to 200 do
+        (* a naive union-find over the positions of the terms *)
+        let parent = Array.init n Fun.id in
+        let rec root i =
+          if Int.equal parent.(i) i then i else root parent.(i)
+        in
+        let pairs =
+          Blist.init (Random.int 10) (fun _ -> (Random.int n, Random.int n))
+        in
+        Blist.iter (fun (i, j) -> parent.(root i) <- root j) pairs ;
+        let uf = Uf.of_list (Blist.map (Pair.map term) pairs) in
+        let uf' =
+          Uf.of_list
+            (Blist.rev_map (fun (i, j) -> (term j, term i)) pairs)
+        in
+        assert (Uf.equal uf uf') ;
+        assert (Int.equal (Uf.hash uf) (Uf.hash uf')) ;
+        for i = 0 to n - 1 do
+          for j = 0 to n - 1 do
+            assert (
+              Bool.equal
+                (Uf.equates uf (term i) (term j))
+                (Int.equal (root i) (root j)) )
+          done ;
+          let r = Uf.find (term i) uf in
+          assert (Term.equal (Uf.find r uf) r)
+        done
+      done )
+
+let () =
+  runtest "Heaps unify into renamed copies of themselves, and no larger ones."
+    (fun () ->
+      let unifies h h' =
+        Option.is_some
+          (Unify.Unidirectional.realize
+             (Heap.unify_partial h h' Unification.trivial_continuation))
+      in
+      Blist.iter
+        (fun h ->
+          let vars = Term.Set.elements (Heap.vars h) in
+          let fresh = Term.fresh_fvars (Heap.vars h) (Blist.length vars) in
+          let h' = Heap.subst (Term.Map.of_list (Blist.combine vars fresh)) h in
+          let w =
+            Term.fresh_fvar (Term.Set.union (Heap.vars h) (Heap.vars h'))
+          in
+          assert (unifies h' h) ;
+          assert (not (unifies (Heap.add_pto h' (w, [w])) h)) )
+        heaps )
+
+let () =
+  runtest "Fingerprints never reject heaps whose spatial atoms match."
+    (fun () ->
+      let shape h =
+        ( Blist.sort Int.compare
+            (Ptos.map_to_list (fun (_, args) -> Blist.length args) h.Heap.ptos)
+        , Blist.sort Predsym.compare
+            (Tpreds.map_to_list Tpred.predsym h.Heap.inds) )
+      in
+      (* sub-multisets of sorted lists *)
+      let rec within cmp l l' =
+        match (l, l') with
+        | [], _ -> true
+        | _, [] -> false
+        | x :: xs, y :: ys ->
+            let c = cmp x y in
+            if Int.equal c 0 then within cmp xs ys
+            else Int.( > ) c 0 && within cmp l ys
+      in
+      Blist.iter
+        (fun h ->
+          Blist.iter
+            (fun h' ->
+              let (ar, ps), (ar', ps') = (shape h, shape h') in
+              assert (
+                (not
+                   ( Blist.equal Int.equal ar ar'
+                   && Blist.equal Predsym.equal ps ps' ))
+                || Heap.spatially_fits h h' ) ;
+              assert (
+                (not
+                   ( within Int.compare ar ar'
+                   && within Predsym.compare ps ps' ))
+                || Heap.spatially_fits ~total:false h h' ) ;
+              assert (
+                Heap.spatially_fits ~total:false h
+                  (Heap.star ~augment_deqs:false h h') ) )
+            heaps )
+        heaps )
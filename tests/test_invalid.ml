@@ -0,0 +1,73 @@
+open Lib
+open Generic
+open Seplog
+
+let defs = Defs.of_channel (open_in "../examples/sl.defs")
+
+(* the first sequent of each of the base SL benchmarks, all of them valid *)
+let valid =
+  let dir = "../benchmarks/sl/base" in
+  let first_line f =
+    let ic = open_in (Filename.concat dir f) in
+    let l = input_line ic in
+    close_in ic ; l
+  in
+  Blist.map
+    (fun f -> Seq.of_string (first_line f))
+    (Blist.sort String.compare
+       (Blist.filter
+          (fun f -> Filename.check_suffix f ".tst")
+          (Array.to_list (Sys.readdir dir))))
+
+let invalid =
+  Blist.map Seq.of_string
+    [ "x->y |- y->x"
+    ; "emp |- x->y"
+    ; "PeList(x,y) |- List(x,y)"
+    ; "PeList(x,y) |- RList(x,y)" ]
+
+let () =
+  runtest "Valid sequents are never shown invalid." (fun () ->
+      Blist.iter
+        (fun strengthen ->
+          Invalid.partition_strengthening := strengthen ;
+          assert (Blist.for_all (fun seq -> not (Invalid.check defs seq)) valid)
+          )
+        [false; true] ;
+      Invalid.partition_strengthening := false )
+
+let () =
+  runtest "Sequents with a countermodel among their base pairs are invalid."
+    (fun () ->
+      assert (Blist.for_all (Invalid.check defs) invalid) ;
+      (* a witness, here or for the converse of a benchmark, is one of the *)
+      (* base pairs of the LHS that no base pair of the RHS is below *)
+      let witnessed ((l, r) as seq) =
+        let lbps, rbps =
+          Pair.map
+            (fun f -> Basepair.minimise (Basepair.pairs_of_form defs f))
+            (l, r)
+        in
+        Option.dest true
+          (fun bp ->
+            Basepair.Set.mem bp lbps
+            && Basepair.Set.for_all (fun bp' -> not (Basepair.leq bp' bp)) rbps
+            )
+          (Invalid.invalidity_witness defs seq)
+      in
+      assert (Blist.for_all witnessed invalid) ;
+      assert (Blist.for_all witnessed (Blist.map (fun (l, r) -> (r, l)) valid))
+      )
+
+let () =
+  runtest "Searching for witnesses in parallel finds the same ones." (fun () ->
+      let seqs = invalid @ valid @ Blist.map (fun (l, r) -> (r, l)) valid in
+      let plain = Blist.map (Invalid.check defs) seqs in
+      Invalid.jobs := 2 ;
+      let par = Blist.map (Invalid.check defs) seqs in
+      Invalid.jobs := 1 ;
+      assert (Blist.equal Bool.equal plain par) ;
+      assert (
+        Blist.for_all
+          (fun w -> Int.( <= ) w.Invalid.worker 1)
+          !Invalid.last_workers ) )
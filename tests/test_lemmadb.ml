@@ -0,0 +1,52 @@
+open Lib
+open Generic
+
+(* The store is only read once per process, so each step of a round trip *)
+(* runs in a process of its own. *)
+let in_child f =
+  match Unix.fork () with
+  | 0 -> exit (if f () then 0 else 1)
+  | pid -> (
+    match Unix.waitpid [] pid with
+    | _, Unix.WEXITED 0 -> true
+    | _ -> false )
+
+let () =
+  Lemmadb.path := Filename.temp_file "lemmadb" "" ;
+  Lemmadb.context := "test"
+
+let () =
+  runtest "Recorded outcomes are read back, merged, by later runs." (fun () ->
+      assert (
+        in_child (fun () ->
+            Lemmadb.record_proof "p" [1; -1] 5 ;
+            Lemmadb.record_proof "p" [0; -1; 2] 3 ;
+            Lemmadb.record_failure "f" 4 ;
+            Lemmadb.record_failure "f" 2 ;
+            Lemmadb.save () ;
+            true ) ) ;
+      assert (
+        in_child (fun () ->
+            Lemmadb.record_failure "p" 1 ;
+            true ) ) ;
+      assert (
+        in_child (fun () ->
+            ( match Lemmadb.find "p" with
+            | Some {Lemmadb.script= Some (script, 3); failed= 1} ->
+                Blist.equal Int.equal script [0; -1; 2]
+            | _ -> false )
+            && ( match Lemmadb.find "f" with
+               | Some {Lemmadb.script= None; failed= 4} -> true
+               | _ -> false )
+            && Option.is_none (Lemmadb.find "q")
+            &&
+            ( Lemmadb.context := "other" ;
+              Option.is_none (Lemmadb.find "p") ) ) ) )
+
+let () =
+  runtest "Normalised keys rename the given identifiers in order." (fun () ->
+      let norm = Lemmadb.normalise ["x"; "y'"; "z"] in
+      assert (String.equal (norm "ls(x,y') * x->y'") "ls(_0,_1') * _0->_1'") ;
+      assert (String.equal (norm "ls(z,x)") (norm "ls(x,z)")) )
+
+let () = Sys.remove !Lemmadb.path
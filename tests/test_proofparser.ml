@@ -0,0 +1,130 @@
+open Lib
+open Generic
+
+(* Proofs are given as lists of edges [(source, target, progressing pairs, *)
+(* other pairs)] over integer nodes and tags, the first edge leaving the *)
+(* root 0. *)
+
+let random_edges n =
+  let subset l = Blist.filter (fun _ -> Random.bool ()) l in
+  let pairs = Blist.cartesian_product [0; 1; 2] [0; 1; 2] in
+  let edge (i, j) =
+    let prog, other =
+      Blist.partition (fun _ -> Random.bool ()) (subset pairs)
+    in
+    (i, j, prog, other)
+  in
+  let nodes = Blist.init n Fun.id in
+  let first = (0, Random.int n) in
+  let rest =
+    Blist.bind
+      (fun i ->
+        Blist.map (fun j -> (i, j))
+          (Blist.filter
+             (fun j ->
+               Int.( < ) (Random.int n) 2
+               && not (Int.equal i 0 && Int.equal j (snd first)) )
+             nodes) )
+      nodes
+  in
+  Blist.map edge (first :: rest)
+
+let expected edges =
+  let nodes =
+    Int.Set.of_list (Blist.bind (fun (i, j, _, _) -> [i; j]) edges)
+  in
+  let tags_of k =
+    Blist.bind
+      (fun (i, j, prog, other) ->
+        let pairs = prog @ other in
+        (if Int.equal i k then Blist.map fst pairs else [])
+        @ if Int.equal j k then Blist.map snd pairs else [] )
+      edges
+  in
+  let premises k =
+    Blist.map
+      (fun (_, j, prog, other) -> (j, prog @ other, prog))
+      (Blist.filter (fun (i, _, _, _) -> Int.equal i k) edges)
+  in
+  Soundcheck.build_proof
+    (Blist.map
+       (fun k ->
+         (k, Int.Set.elements (Int.Set.of_list (tags_of k)), premises k) )
+       (Int.Set.elements nodes))
+
+(* print with arbitrary whitespace between tokens and identifiers using all *)
+(* the characters allowed in them *)
+let print edges =
+  let ws () = Blist.nth [" "; "\n"; "\t  "; " \r\n"] (Random.int 4) in
+  let tag t = Printf.sprintf "t_%d'" t in
+  let pairs ps =
+    String.concat ("," ^ ws ())
+      (Blist.map
+         (fun (t, t') ->
+           String.concat (ws ()) ["("; tag t; ","; tag t'; ")"] )
+         ps)
+  in
+  let line (i, j, prog, other) =
+    String.concat (ws ())
+      [ Printf.sprintf "n.%d-%d" i i
+      ; "->"
+      ; Printf.sprintf "n.%d-%d" j j
+      ; ":"
+      ; "{" ^ pairs prog ^ "}"
+      ; ","
+      ; "{" ^ pairs other ^ "}" ]
+  in
+  String.concat (ws ()) (Blist.map line edges) ^ ws () ^ ";"
+
+let same (prf, init) prf' =
+  let r = Soundcheck.check_proof_report ~init prf in
+  let r' = Soundcheck.check_proof_report prf' in
+  Bool.equal r.Soundcheck.sound r'.Soundcheck.sound
+  && Int.equal (fst r.Soundcheck.size) (fst r'.Soundcheck.size)
+  && Int.equal (snd r.Soundcheck.size) (snd r'.Soundcheck.size)
+
+let fails_at pos s =
+  match Proofparser.of_string s with
+  | exception Proofparser.Error (pos', _) -> Int.equal pos pos'
+  | _ -> false
+
+let () =
+  Random.init 0 ;
+  runtest "Every proof in a file is read as built directly." (fun () ->
+      let proofs =
+        Blist.init 300 (fun _ -> random_edges (1 + Random.int 8))
+      in
+      let parsed =
+        Blist.rev
+          (Proofparser.fold
+             (fun ps p -> p :: ps)
+             []
+             (String.concat "\n" (Blist.map print proofs)))
+      in
+      assert (Int.equal (Blist.length parsed) (Blist.length proofs)) ;
+      assert (
+        Blist.for_all2 (fun p edges -> same p (expected edges)) parsed proofs
+      ) )
+
+let () =
+  runtest "A single proof need not be terminated." (fun () ->
+      let prf =
+        Proofparser.of_string "a -> b : {(x, x)}, {}\nb -> a : {}, {(x, x)}"
+      in
+      assert (
+        same prf
+          (Soundcheck.build_proof
+             [ (0, [0], [(1, [(0, 0)], [(0, 0)])])
+             ; (1, [0], [(0, [(0, 0)], [])]) ]) ) )
+
+let () =
+  runtest "Malformed proofs are rejected where they go wrong." (fun () ->
+      assert (fails_at 6 "n0 -> : {}, {}") ;
+      assert (fails_at 19 "n0 -> n1 : {(a, b)}") ;
+      assert (fails_at 35 "n0 -> n1 : {}, {}\nn0 -> n1 : {}, {}") ;
+      assert (fails_at 20 "n0 -> n1 : {}, {} ; n1") ;
+      (* a failure leaves nothing behind for the next proof *)
+      assert (
+        same
+          (Proofparser.of_string "m -> m : {(a, a)}, {}")
+          (Soundcheck.build_proof [(0, [0], [(0, [(0, 0)], [(0, 0)])])]) ) )
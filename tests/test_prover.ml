@@ -0,0 +1,206 @@
+open Lib
+open Generic
+open Seplog
+
+module Prover = Prover.Make (Seq)
+
+let maxbound = 6
+
+(* the first, untagged, sequent of each of the base SL benchmarks *)
+let sequents =
+  let dir = "../benchmarks/sl/base" in
+  let first_line f =
+    let ic = open_in (Filename.concat dir f) in
+    let l = input_line ic in
+    close_in ic ; l
+  in
+  Blist.map
+    (fun f -> Seq.of_string (first_line f))
+    (Blist.sort String.compare
+       (Blist.filter
+          (fun f -> Filename.check_suffix f ".tst")
+          (Array.to_list (Sys.readdir dir))))
+
+let search seq = Prover.idfs 1 maxbound !Rules.axioms !Rules.rules seq
+
+let sound = function
+  | None -> true
+  | Some prf -> Prover.Proof.is_closed prf && Prover.Proof.check prf
+
+let () = Rules.setup (Defs.of_channel (open_in "../examples/sl.defs"))
+
+let () =
+  runtest "Proofs built out of transposition table entries are sound."
+    (fun () ->
+      Prover.transpositions := true ;
+      assert (Blist.for_all (fun seq -> sound (search seq)) sequents) ;
+      Prover.transpositions := false )
+
+let () =
+  runtest "Proofs found while skipping nogoods are sound." (fun () ->
+      Prover.nogoods := true ;
+      assert (Blist.for_all (fun seq -> sound (search seq)) sequents) ;
+      Prover.transpositions := true ;
+      assert (Blist.for_all (fun seq -> sound (search seq)) sequents) ;
+      Prover.transpositions := false ;
+      Prover.nogoods := false )
+
+let () =
+  runtest "Searching the root alternatives in parallel proves the same."
+    (fun () ->
+      let plain = Blist.map search sequents in
+      Prover.jobs := 2 ;
+      let par = Blist.map search sequents in
+      Prover.jobs := 1 ;
+      assert (
+        Blist.for_all2
+          (fun p p' -> Bool.equal (Option.is_some p) (Option.is_some p'))
+          plain par ) ;
+      assert (Blist.for_all sound par) )
+
+let () =
+  runtest "Best-first search finds sound proofs under every heuristic."
+    (fun () ->
+      Blist.iter
+        (fun (_, h) ->
+          assert (
+            Blist.for_all
+              (fun seq ->
+                sound
+                  (Prover.best_first maxbound h !Rules.axioms !Rules.rules seq)
+                )
+              sequents ) )
+        Prover.heuristics )
+
+let () =
+  runtest "Breadth-first search is sound and falls back to idfs when full."
+    (fun () ->
+      let bfs seq = Prover.bfs 1 maxbound !Rules.axioms !Rules.rules seq in
+      assert (Blist.for_all (fun seq -> sound (bfs seq)) sequents) ;
+      let cap = !Prover.bfs_frontier_cap in
+      Prover.bfs_frontier_cap := 1 ;
+      let fallback = Blist.map bfs sequents in
+      Prover.bfs_frontier_cap := cap ;
+      assert (
+        Blist.for_all2
+          (fun p seq ->
+            Bool.equal (Option.is_some p) (Option.is_some (search seq)) )
+          fallback sequents ) )
+
+let () =
+  runtest "Profiling files rules under their names and changes no outcome."
+    (fun () ->
+      let plain = Blist.map search sequents in
+      Stats.Rules.reset () ;
+      Stats.Rules.enabled := true ;
+      let profiled = Blist.map search sequents in
+      Stats.Rules.enabled := false ;
+      assert (
+        Blist.for_all2
+          (fun p p' -> Bool.equal (Option.is_some p) (Option.is_some p'))
+          plain profiled ) ;
+      let calls name =
+        Option.dest 0
+          (fun e -> e.Stats.Rules.calls)
+          (Blist.assoc_opt name (Stats.Rules.entries ()))
+      in
+      assert (Int.( > ) (calls "Axioms") 0) ;
+      assert (Int.( > ) (calls "Intro/Unf./Backl") 0) )
+
+let () =
+  runtest "Every node equal up to tags is a back-link candidate." (fun () ->
+      let complete prf =
+        let module P = Prover.Proof in
+        P.fold
+          (fun idx _ ok ->
+            let candidates = P.candidates_upto_tags idx prf in
+            ok
+            && P.fold
+                 (fun idx' _ ok ->
+                   ok
+                   && ( Int.equal idx idx'
+                      || (not
+                            (Seq.equal_upto_tags (P.get_seq idx prf)
+                               (P.get_seq idx' prf)))
+                      || Blist.exists (Int.equal idx') candidates ) )
+                 prf true )
+          prf true
+      in
+      assert (
+        Blist.for_all
+          (fun seq -> Option.dest true complete (search seq))
+          sequents ) )
+
+let () =
+  runtest "The scripts stored for proofs rebuild them." (fun () ->
+      let ax, r = (!Rules.axioms, !Rules.rules) in
+      assert (
+        Blist.for_all
+          (fun seq ->
+            Option.dest true
+              (fun prf ->
+                let prf' = Prover.rebuild ax r seq (Prover.script ax r prf) in
+                Int.equal (Prover.Proof.size prf) (Prover.Proof.size prf')
+                && sound (Some prf') )
+              (search seq) )
+          sequents ) )
+
+let () =
+  runtest "A search interrupted half way resumes to a proof." (fun () ->
+      let calls = ref 0 in
+      let counted stop r idx prf =
+        if Int.equal !calls stop then raise Timeout ;
+        incr calls ;
+        r idx prf
+      in
+      let search stop seq =
+        calls := 0 ;
+        Prover.idfs 1 maxbound !Rules.axioms (counted stop !Rules.rules) seq
+      in
+      Prover.checkpoint := Filename.temp_file "checkpoint" "" ;
+      Sys.remove !Prover.checkpoint ;
+      Blist.iter
+        (fun seq ->
+          if Option.is_some (search (-1) seq) && Int.( > ) !calls 0 then (
+            let stop = !calls / 2 in
+            assert (
+              match search stop seq with
+              | exception Timeout -> Sys.file_exists !Prover.checkpoint
+              | _ -> false ) ;
+            assert (
+              let resumed = search (-1) seq in
+              Option.is_some resumed && sound resumed ) ;
+            assert (not (Sys.file_exists !Prover.checkpoint)) ) )
+        sequents ;
+      Prover.checkpoint := "" )
+
+let () =
+  runtest "Racing a portfolio proves at least what its idfs entry does."
+    (fun () ->
+      let module F = Frontend.Make (Prover) in
+      F.maxbound := maxbound ;
+      F.portfolio_size := Blist.length !F.portfolio ;
+      F.portfolio_log := Filename.temp_file "portfolio" "" ;
+      let ax, r = (!Rules.axioms, !Rules.rules) in
+      Blist.iter
+        (fun seq ->
+          let res = F.idfs ax r seq in
+          assert (sound res) ;
+          assert (Option.is_some res || Option.is_none (search seq)) ;
+          (* the settings of the winner are not left behind *)
+          assert (String.equal !F.heuristic "") ;
+          assert (not !F.breadth_first) ;
+          assert (Int.equal !F.minbound 1) )
+        sequents ;
+      let names = "-" :: Blist.map fst !F.portfolio in
+      let ic = open_in !F.portfolio_log in
+      let rec winners n =
+        match input_line ic with
+        | l ->
+            let name = Blist.hd (String.split_on_char '\t' l) in
+            assert (Blist.exists (String.equal name) names) ;
+            winners (n + 1)
+        | exception End_of_file -> close_in ic ; n
+      in
+      assert (Int.equal (winners 0) (Blist.length sequents)) ;
+      Sys.remove !F.portfolio_log )
@@ -0,0 +1,120 @@
+open Lib
+open Generic
+
+(* Proofs are given as lists of [(node, tags, premises)] where each premise *)
+(* is [(target, all tag pairs, progressing tag pairs)], see *)
+(* [Soundcheck.build_proof]. *)
+
+let report prf = Soundcheck.check_proof_report (Soundcheck.build_proof prf)
+
+let same_size (n, e) (n', e') = Int.equal n n' && Int.equal e e'
+
+(* a cycle 0 -> 1 -> 2 -> 0 and a dead chain of [k] nodes hanging off 1 *)
+let cycle_with_dead_chain prog k =
+  let id = [(1, 1)] in
+  [ (0, [1], [(1, id, [])])
+  ; (1, [1], [(2, id, []); (3, id, [])])
+  ; (2, [1], [(0, id, prog)]) ]
+  @ Blist.init k (fun i ->
+        (3 + i, [1], if Int.equal i (k - 1) then [] else [(4 + i, id, [])]) )
+
+(* nodes carry some of the tags 1 and 2 and have about two premises each *)
+let random_proof n =
+  let tags =
+    Array.init n (fun _ -> Blist.filter (fun _ -> Random.bool ()) [1; 2])
+  in
+  let subset l = Blist.filter (fun _ -> Random.bool ()) l in
+  let premise i j =
+    let all = subset (Blist.cartesian_product tags.(i) tags.(j)) in
+    (j, all, subset all)
+  in
+  Blist.init n (fun i ->
+      ( i
+      , tags.(i)
+      , Blist.map (premise i)
+          (Blist.filter
+             (fun _ -> Int.( < ) (Random.int n) 2)
+             (Blist.init n Fun.id)) ) )
+
+(* rename every node but the root 0 *)
+let shuffle prf =
+  let n = Blist.length prf in
+  let perm = Array.init n Fun.id in
+  for i = n - 1 downto 2 do
+    let j = 1 + Random.int i in
+    let x = perm.(i) in
+    perm.(i) <- perm.(j) ;
+    perm.(j) <- x
+  done ;
+  Blist.map
+    (fun (i, tags, ps) ->
+      let ps = Blist.map (fun (j, all, prog) -> (perm.(j), all, prog)) ps in
+      (perm.(i), tags, ps) )
+    prf
+
+(* put a fresh node on every edge, passing on the tags of the target *)
+(* unchanged, so that minimisation has to compose it away again *)
+let subdivide prf =
+  let fresh = ref (Blist.length prf) in
+  let extra = ref [] in
+  let tags_of j =
+    let _, tags, _ = Blist.nth prf j in
+    tags
+  in
+  let split (j, all, prog) =
+    let k = !fresh in
+    let tags = tags_of j in
+    incr fresh ;
+    extra := (k, tags, [(j, Blist.map (fun t -> (t, t)) tags, [])]) :: !extra ;
+    (k, all, prog)
+  in
+  let nodes =
+    Blist.map (fun (i, tags, ps) -> (i, tags, Blist.map split ps)) prf
+  in
+  nodes @ !extra
+
+let () =
+  runtest "A cycle is sound iff it progresses, and minimises to a self-loop."
+    (fun () ->
+      let r = report (cycle_with_dead_chain [(1, 1)] 1) in
+      let r' = report (cycle_with_dead_chain [] 1) in
+      assert r.Soundcheck.sound ;
+      assert (not r'.Soundcheck.sound) ;
+      assert (same_size r.Soundcheck.min_size (1, 1)) ;
+      assert (same_size r'.Soundcheck.min_size (1, 1)) )
+
+let () =
+  runtest "Long dead chains are removed entirely." (fun () ->
+      let r = report (cycle_with_dead_chain [(1, 1)] 500) in
+      assert (same_size r.Soundcheck.size (503, 503)) ;
+      assert (same_size r.Soundcheck.min_size (1, 1)) )
+
+let () =
+  runtest "A proof without cycles minimises to its root." (fun () ->
+      let r =
+        report
+          [(0, [], [(1, [], []); (2, [], [])]); (1, [], []); (2, [], [])]
+      in
+      assert r.Soundcheck.sound ;
+      assert (same_size r.Soundcheck.min_size (1, 0)) )
+
+let () =
+  Random.init 0 ;
+  runtest "Verdicts do not depend on the order the worklists visit nodes in."
+    (fun () ->
+      for _ = 1 to 500 do
+        let prf = random_proof (1 + Random.int 8) in
+        assert (
+          Bool.equal (report prf).Soundcheck.sound
+            (report (shuffle prf)).Soundcheck.sound )
+      done )
+
+let () =
+  Random.init 0 ;
+  runtest "Fusing composes tag relations along the fused edges." (fun () ->
+      for _ = 1 to 500 do
+        let prf = random_proof (1 + Random.int 8) in
+        assert (
+          Bool.equal (report prf).Soundcheck.sound
+            (report (subdivide prf)).Soundcheck.sound )
+      done )